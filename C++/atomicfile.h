@@ -0,0 +1,59 @@
+// atomicfile.h
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+
+#include <string>
+#include <iostream>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Flushes a file's contents, or a directory's entries, to disk
+inline bool syncPath(const std::string& path, bool directory = false) {
+    int fd = ::open(path.c_str(), directory ? (O_RDONLY | O_DIRECTORY) : O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+inline std::string parentDirectory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+// Replaces the file at path so that a crash at any point leaves either its
+// old contents or the complete new ones. write(tempPath) fills a temporary
+// file next to it and returns false on failure; the temporary file is then
+// fsynced and renamed over path, and the directory fsynced so the rename
+// itself survives a crash.
+template <typename Writer>
+bool replaceFile(const std::string& path, Writer write) {
+    std::string tempPath = path + ".tmp";
+    if (!write(tempPath)) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    if (!syncPath(tempPath)) {
+        std::cerr << "Failed to sync " << tempPath << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to replace " << path << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    if (!syncPath(parentDirectory(path), true)) {
+        std::cerr << "Failed to sync directory of " << path << std::endl;
+    }
+    return true;
+}
+
+#endif // ATOMICFILE_H
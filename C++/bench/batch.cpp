@@ -0,0 +1,65 @@
+// bench/batch.cpp
+// Reassigns every task of one user to another, first with one updateTask
+// call per task and then back again with a single applyBatch, both with
+// synchronous durability.
+//
+// Build: g++ -std=c++17 -O2 -pthread -I.. batch.cpp -o batch
+// Usage: ./batch [tasks]
+#include "taskmanager.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    int rows = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const std::string tasksFile = "batch_bench_tasks.txt";
+    const std::string usersFile = "batch_bench_users.txt";
+    {
+        std::ofstream users(usersFile, std::ios::trunc);
+        users << "leaver|pw\nheir|pw\n";
+        std::ofstream tasks(tasksFile, std::ios::trunc);
+        for (int i = 1; i <= rows; ++i) {
+            Task task(i, "Handover task " + std::to_string(i), "bench", "leaver",
+                      static_cast<Priority>(i % 3), false);
+            tasks << task.serialize() << '\n';
+        }
+    }
+
+    {
+        TaskManager taskManager(tasksFile, usersFile);
+        taskManager.setMinCompactionRecords(static_cast<size_t>(-1));
+        int leaver = taskManager.login("leaver", "pw");
+        int heir = taskManager.login("heir", "pw");
+
+        auto start = std::chrono::steady_clock::now();
+        for (const Task& task : taskManager.getPersonalTasks(leaver)) {
+            taskManager.updateTask(task.getId(), task.getTitle(), task.getCategory(), "heir",
+                                   task.isCompleted(), task.getPriority(), task.getIsShared(), leaver);
+        }
+        double single = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        TaskBatch batch;
+        std::vector<Task> handedOver = taskManager.getPersonalTasks(heir);
+        batch.reserve(handedOver.size());
+        for (const Task& task : handedOver) {
+            batch.update(task.getId(), task.getTitle(), task.getCategory(), "leaver",
+                         task.isCompleted(), task.getPriority(), task.getIsShared());
+        }
+        taskManager.applyBatch(batch, heir);
+        double batched = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << rows << " reassignments\n" << std::fixed << std::setprecision(2)
+                  << "updateTask per task  " << std::setw(10) << single << " ms\n"
+                  << "one applyBatch       " << std::setw(10) << batched << " ms\n";
+    }
+    std::remove(tasksFile.c_str());
+    std::remove((tasksFile + ".log").c_str());
+    std::remove(usersFile.c_str());
+    std::remove((usersFile + ".log").c_str());
+    return 0;
+}
@@ -0,0 +1,75 @@
+// bench/columns.cpp
+// Compares the pending-by-priority dashboard and an unindexed filter query
+// over the row store against the same work over the columnar copy.
+//
+// Build: g++ -std=c++17 -O2 -pthread -I.. columns.cpp -o columns
+// Usage: ./columns [tasks] [repetitions]
+#include "taskmanager.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+template <typename Work>
+static double bestMillis(int repetitions, Work work) {
+    double best = 1e300;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        work();
+        double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (millis < best) {
+            best = millis;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int rows = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    const std::string tasksFile = "columns_bench_tasks.txt";
+    const std::string usersFile = "columns_bench_users.txt";
+    {
+        std::ofstream users(usersFile, std::ios::trunc);
+        users << "user0|pw\n";
+        std::ofstream tasks(tasksFile, std::ios::trunc);
+        for (int i = 1; i <= rows; ++i) {
+            Task task(i, "Synthetic task number " + std::to_string(i), "bench",
+                      "user" + std::to_string(i % 16), static_cast<Priority>(i % 3), i % 5 == 0);
+            task.setCompleted(i % 2 == 0);
+            tasks << task.serialize() << '\n';
+        }
+    }
+
+    {
+        TaskManager taskManager(tasksFile, usersFile);
+        taskManager.setMinCompactionRecords(static_cast<size_t>(-1));
+        int sessionId = taskManager.login("user0", "pw");
+
+        TaskQuery query;
+        query.priority = Priority::HIGH;
+        query.isShared = false;
+        query.sortBy = SortField::CREATED_AT;
+        query.limit = 20;
+
+        std::cout << rows << " tasks, best of " << repetitions << "\n"
+                  << "layout     pending-by-priority  filter query\n";
+        for (bool columnar : {false, true}) {
+            taskManager.setColumnarStorage(columnar);
+            double dashboard = bestMillis(repetitions, [&] { taskManager.getPendingByPriority(sessionId); });
+            double filter = bestMillis(repetitions, [&] { taskManager.queryTasks(sessionId, query); });
+            std::cout << std::left << std::setw(11) << (columnar ? "columns" : "rows")
+                      << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(16) << dashboard << " ms"
+                      << std::setw(13) << filter << " ms\n";
+        }
+    }
+    std::remove(tasksFile.c_str());
+    std::remove((tasksFile + ".log").c_str());
+    std::remove(usersFile.c_str());
+    std::remove((usersFile + ".log").c_str());
+    return 0;
+}
@@ -0,0 +1,100 @@
+// bench/contention.cpp
+// Measures how TaskManager throughput scales with thread count. Each thread
+// mostly looks tasks up by id, lists its user's personal tasks every 64th
+// operation, and updates a task for the requested percentage of operations.
+//
+// Build: g++ -std=c++17 -O2 -pthread -I.. contention.cpp -o contention
+// Usage: ./contention [tasks] [seconds per run] [max threads] [write percent]
+#include "taskmanager.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    int taskTotal = argc > 1 ? std::atoi(argv[1]) : 100000;
+    double seconds = argc > 2 ? std::atof(argv[2]) : 1.0;
+    int maxThreads = argc > 3 ? std::atoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+    int writePercent = argc > 4 ? std::atoi(argv[4]) : 0;
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    const std::string tasksFile = "contention_tasks.txt";
+    const std::string usersFile = "contention_users.txt";
+    const int userTotal = 16;
+    double baseline = 0;
+    {
+        TaskManager taskManager(tasksFile, usersFile);
+        taskManager.setDurability(Durability::ASYNC);
+        taskManager.setMinCompactionRecords(static_cast<size_t>(-1));
+
+        std::vector<int> sessions;
+        for (int u = 0; u < userTotal; ++u) {
+            std::string username = "user" + std::to_string(u);
+            taskManager.addUser(username, "pw");
+            sessions.push_back(taskManager.login(username, "pw"));
+        }
+        for (int i = 0; i < taskTotal; ++i) {
+            int user = i % userTotal;
+            taskManager.addTask("Task " + std::to_string(i), "bench", "user" + std::to_string(user),
+                                Priority::MEDIUM, i % 10 == 0, sessions[user]);
+        }
+
+        std::cout << "threads  ops/sec        speedup\n";
+        for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+            std::atomic<bool> stop(false);
+            std::vector<long long> counts(threadCount, 0);
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threadCount; ++t) {
+                workers.emplace_back([&, t] {
+                    std::mt19937 rng(t + 1);
+                    std::uniform_int_distribution<int> pickTask(1, taskTotal);
+                    std::uniform_int_distribution<int> pickPercent(0, 99);
+                    int user = t % userTotal;
+                    int sessionId = sessions[user];
+                    long long ops = 0;
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        int taskId = pickTask(rng);
+                        if (pickPercent(rng) < writePercent) {
+                            taskManager.updateTask(taskId, "Updated", "bench", "user" + std::to_string(user),
+                                                   false, Priority::HIGH, true, sessionId);
+                        } else if (ops % 64 == 0) {
+                            taskManager.getPersonalTasks(sessionId);
+                        } else {
+                            taskManager.getTaskById(taskId, sessionId);
+                        }
+                        ++ops;
+                    }
+                    counts[t] = ops;
+                });
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+            stop = true;
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            long long total = 0;
+            for (long long count : counts) {
+                total += count;
+            }
+            double rate = total / seconds;
+            if (threadCount == 1) {
+                baseline = rate;
+            }
+            std::cout << std::left << std::setw(9) << threadCount
+                      << std::setw(15) << static_cast<long long>(rate)
+                      << std::fixed << std::setprecision(2) << rate / baseline << "x\n";
+        }
+    }
+    std::remove(tasksFile.c_str());
+    std::remove((tasksFile + ".log").c_str());
+    std::remove(usersFile.c_str());
+    std::remove((usersFile + ".log").c_str());
+    return 0;
+}
@@ -0,0 +1,116 @@
+// bench/parse.cpp
+// Compares tasks.txt load throughput of the original getline/substr/stoi
+// parser against the streaming string_view parser in textparser.h.
+//
+// Build: g++ -std=c++17 -O2 -I.. parse.cpp -o parse
+// Usage: ./parse [rows] [repetitions]
+#include "textparser.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The parser tasks.txt was read with before textparser.h, kept verbatim for
+// comparison
+static Task legacyDeserialize(const std::string& data) {
+    std::vector<std::string> parts;
+    std::string part;
+    size_t pos = 0;
+    std::string delimiter = "|";
+    std::string dataCopy = data;
+
+    while ((pos = dataCopy.find(delimiter)) != std::string::npos) {
+        part = dataCopy.substr(0, pos);
+        parts.push_back(part);
+        dataCopy.erase(0, pos + delimiter.length());
+    }
+    parts.push_back(dataCopy);
+
+    if (parts.size() < 8) {
+        throw std::runtime_error("Invalid task data format");
+    }
+
+    int id = std::stoi(parts[0]);
+    std::string title = parts[1];
+    std::string category = parts[2];
+    std::string assignedTo = parts[3];
+    bool completed = parts[4] == "1";
+    Priority priority = static_cast<Priority>(std::stoi(parts[5]));
+    bool isShared = parts[6] == "1";
+    time_t createdAt = std::stol(parts[7]);
+
+    Task task(id, title, category, assignedTo, priority, isShared);
+    task.setCompleted(completed);
+    task.setCreatedAt(createdAt);
+    return task;
+}
+
+static size_t legacyLoad(const std::string& path, std::vector<Task>& tasks) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        Task task = legacyDeserialize(line);
+        tasks.push_back(task);
+    }
+    return tasks.size();
+}
+
+static size_t streamingLoad(const std::string& path, std::vector<Task>& tasks) {
+    return parseTaskFile(path, [&tasks](Task&& task) {
+        tasks.push_back(std::move(task));
+    }, [](size_t lineNumber, const char* message) {
+        std::cerr << "line " << lineNumber << ": " << message << "\n";
+    });
+}
+
+template <typename Loader>
+static double measure(const char* name, Loader load, const std::string& path,
+                      double megabytes, int repetitions) {
+    double best = 0;
+    for (int r = 0; r < repetitions; ++r) {
+        std::vector<Task> tasks;
+        auto start = std::chrono::steady_clock::now();
+        size_t loaded = load(path, tasks);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double rate = megabytes / seconds;
+        if (rate > best) {
+            best = rate;
+        }
+        if (r == 0) {
+            std::cout << std::left << std::setw(11) << name << loaded << " tasks";
+        }
+    }
+    std::cout << ", best " << std::fixed << std::setprecision(1) << best << " MB/s\n";
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int rows = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 3;
+    const std::string path = "parse_bench_tasks.txt";
+
+    {
+        std::ofstream file(path, std::ios::trunc);
+        const char* categories[] = {"Work", "Home", "Errands", "Study"};
+        for (int i = 1; i <= rows; ++i) {
+            Task task(i, "Synthetic task number " + std::to_string(i), categories[i % 4],
+                      "user" + std::to_string(i % 100), static_cast<Priority>(i % 3), i % 5 == 0);
+            task.setCompleted(i % 2 == 0);
+            file << task.serialize() << '\n';
+        }
+    }
+    std::ifstream sized(path, std::ios::ate | std::ios::binary);
+    double megabytes = static_cast<double>(sized.tellg()) / (1024.0 * 1024.0);
+    std::cout << rows << " rows, " << std::fixed << std::setprecision(1) << megabytes << " MB\n";
+
+    double legacy = measure("legacy", legacyLoad, path, megabytes, repetitions);
+    double streaming = measure("streaming", streamingLoad, path, megabytes, repetitions);
+    std::cout << "speedup    " << std::setprecision(2) << streaming / legacy << "x\n";
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,564 @@
+// bench/taskbench.cpp
+// Benchmark suite for TaskManager. Runs the selected groups and prints the
+// results as one JSON document, so runs can be stored and compared:
+//   load   load and save of synthetic snapshots, text and binary, per size
+//   ops    per-call latency of addTask, getTaskById, updateTask, patchTask
+//          and deleteTask
+//   list   personal and shared listing throughput with many users
+//   mixed  multi-threaded read/write workload at 1, 2, 4... threads
+// Latencies are in microseconds and throughputs are per second. Work files
+// are created in the current directory and removed afterwards.
+//
+// Build: cmake target taskbench, or g++ -std=c++17 -O2 -pthread -I.. taskbench.cpp -o taskbench
+// Usage: ./taskbench [--only load,ops,list,mixed] [--sizes 10000,1000000,10000000]
+//                    [--ops N] [--users N] [--tasks N] [--threads N]
+//                    [--read-percent P] [--seconds S] [--sync] [--quick] [--out file]
+#include "taskmanager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options {
+    std::vector<long> sizes{10000, 1000000, 10000000};
+    std::vector<std::string> groups{"load", "ops", "list", "mixed"};
+    size_t ops = 100000;      // Calls per operation in the ops group
+    int users = 1000;         // Users in the list group
+    int tasks = 100000;       // Tasks in the ops, list and mixed groups
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int readPercent = 90;
+    double seconds = 2.0;     // Length of each timed run in list and mixed
+    bool sync = false;        // Wait for the journal fsync on every mutation
+    std::string outPath;
+};
+
+const std::string TASKS_FILE = "taskbench_tasks.txt";
+const std::string USERS_FILE = "taskbench_users.txt";
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double microsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// Minimal JSON emitter; keys and strings are plain identifiers, so nothing
+// needs escaping
+class JsonWriter {
+private:
+    std::ostream& out;
+    std::vector<bool> empty; // One entry per open object or array
+
+    void indent() { out << '\n' << std::string(empty.size() * 2, ' '); }
+
+    void separate(const char* key) {
+        if (!empty.empty()) {
+            if (!empty.back()) {
+                out << ',';
+            }
+            empty.back() = false;
+            indent();
+        }
+        if (key) {
+            out << '"' << key << "\": ";
+        }
+    }
+
+    void open(const char* key, char bracket) {
+        separate(key);
+        out << bracket;
+        empty.push_back(true);
+    }
+
+    void close(char bracket) {
+        bool wasEmpty = empty.back();
+        empty.pop_back();
+        if (!wasEmpty) {
+            indent();
+        }
+        out << bracket;
+        if (empty.empty()) {
+            out << '\n';
+        }
+    }
+
+public:
+    explicit JsonWriter(std::ostream& out) : out(out) {}
+
+    void beginObject(const char* key = nullptr) { open(key, '{'); }
+    void endObject() { close('}'); }
+    void beginArray(const char* key = nullptr) { open(key, '['); }
+    void endArray() { close(']'); }
+
+    void field(const char* key, double value) {
+        separate(key);
+        out << value;
+    }
+
+    void field(const char* key, long long value) {
+        separate(key);
+        out << value;
+    }
+
+    void field(const char* key, size_t value) { field(key, static_cast<long long>(value)); }
+    void field(const char* key, int value) { field(key, static_cast<long long>(value)); }
+
+    void field(const char* key, bool value) {
+        separate(key);
+        out << (value ? "true" : "false");
+    }
+
+    void field(const char* key, const std::string& value) {
+        separate(key);
+        out << '"' << value << '"';
+    }
+};
+
+// Per-call latencies in microseconds
+class Samples {
+private:
+    std::vector<double> values;
+
+public:
+    void reserve(size_t count) { values.reserve(count); }
+    void add(double micros) { values.push_back(micros); }
+    void append(const Samples& other) { values.insert(values.end(), other.values.begin(), other.values.end()); }
+    size_t size() const { return values.size(); }
+
+    // Sorts the samples in place and writes count, mean and percentiles
+    void write(JsonWriter& json, const char* key) {
+        json.beginObject(key);
+        json.field("count", values.size());
+        if (!values.empty()) {
+            std::sort(values.begin(), values.end());
+            double total = 0;
+            for (double value : values) {
+                total += value;
+            }
+            auto at = [this](double fraction) {
+                return values[static_cast<size_t>(fraction * static_cast<double>(values.size() - 1))];
+            };
+            json.field("mean_us", total / static_cast<double>(values.size()));
+            json.field("p50_us", at(0.5));
+            json.field("p90_us", at(0.9));
+            json.field("p99_us", at(0.99));
+            json.field("p999_us", at(0.999));
+            json.field("max_us", values.back());
+        }
+        json.endObject();
+    }
+};
+
+// user0 ... user<count-1>, all with password "pw", hashed at the lowest
+// cost so password hashing stays out of load and login timings
+static void writeUsers(int count) {
+    std::ofstream users(USERS_FILE, std::ios::trunc);
+    for (int u = 0; u < count; ++u) {
+        users << User("user" + std::to_string(u), "pw", 1).serialize() << '\n';
+    }
+}
+
+// Task i belongs to user (i % users); every tenth task is shared
+static void writeTasks(long rows, int users) {
+    std::ofstream tasks(TASKS_FILE, std::ios::trunc);
+    for (long i = 1; i <= rows; ++i) {
+        tasks << formatTaskRecord(static_cast<int>(i), "Synthetic task " + std::to_string(i),
+                                  "category" + std::to_string(i % 20), "user" + std::to_string(i % users),
+                                  i % 4 == 0, static_cast<Priority>(i % 3), i % 10 == 0, 1700000000 + i)
+              << '\n';
+    }
+}
+
+static long long fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file.is_open() ? static_cast<long long>(file.tellg()) : 0;
+}
+
+static void removeWorkFiles() {
+    for (const std::string& path : {TASKS_FILE, TASKS_FILE + ".log", TASKS_FILE + ".log.1", TASKS_FILE + ".tmp",
+                                    USERS_FILE, USERS_FILE + ".log"}) {
+        std::remove(path.c_str());
+    }
+}
+
+static std::vector<int> loginAll(TaskManager& taskManager, int users) {
+    std::vector<int> sessions;
+    for (int u = 0; u < users; ++u) {
+        sessions.push_back(taskManager.login("user" + std::to_string(u), "pw"));
+    }
+    return sessions;
+}
+
+static void runLoad(const Options& options, JsonWriter& json) {
+    json.beginArray("load");
+    for (long rows : options.sizes) {
+        std::cerr << "load: " << rows << " rows" << std::endl;
+        removeWorkFiles();
+        writeUsers(16);
+        auto start = Clock::now();
+        writeTasks(rows, 16);
+        double generated = millisSince(start);
+        long long textBytes = fileSize(TASKS_FILE);
+
+        double textLoad, textSave, binarySave, binaryLoad;
+        {
+            start = Clock::now();
+            TaskManager taskManager(TASKS_FILE, USERS_FILE);
+            textLoad = millisSince(start);
+            start = Clock::now();
+            taskManager.saveTasks();
+            textSave = millisSince(start);
+            taskManager.setSnapshotFormat(SnapshotFormat::BINARY);
+            start = Clock::now();
+            taskManager.saveTasks();
+            binarySave = millisSince(start);
+        }
+        long long binaryBytes = fileSize(TASKS_FILE);
+        {
+            start = Clock::now();
+            TaskManager taskManager(TASKS_FILE, USERS_FILE);
+            binaryLoad = millisSince(start);
+        }
+
+        json.beginObject();
+        json.field("rows", static_cast<long long>(rows));
+        json.field("generate_ms", generated);
+        json.field("text_bytes", textBytes);
+        json.field("text_load_ms", textLoad);
+        json.field("text_save_ms", textSave);
+        json.field("binary_bytes", binaryBytes);
+        json.field("binary_load_ms", binaryLoad);
+        json.field("binary_save_ms", binarySave);
+        json.field("text_load_rows_per_s", rows / (textLoad / 1000.0));
+        json.endObject();
+    }
+    json.endArray();
+    removeWorkFiles();
+}
+
+static void runOps(const Options& options, JsonWriter& json) {
+    std::cerr << "ops: " << options.ops << " calls each" << std::endl;
+    removeWorkFiles();
+    writeUsers(1);
+    writeTasks(options.tasks, 1);
+    json.beginObject("ops");
+    {
+        TaskManager taskManager(TASKS_FILE, USERS_FILE);
+        taskManager.setDurability(options.sync ? Durability::SYNC : Durability::ASYNC);
+        taskManager.setMinCompactionRecords(static_cast<size_t>(-1));
+        int sessionId = taskManager.login("user0", "pw");
+        std::mt19937 random(42);
+
+        Samples adds, gets, updates, patches, deletes;
+        std::vector<int> ids;
+        ids.reserve(options.ops);
+        adds.reserve(options.ops);
+        for (size_t i = 0; i < options.ops; ++i) {
+            auto start = Clock::now();
+            ids.push_back(taskManager.addTask("Benchmark task " + std::to_string(i), "bench", "user0",
+                                              Priority::MEDIUM, false, sessionId));
+            adds.add(microsSince(start));
+        }
+        gets.reserve(options.ops);
+        for (size_t i = 0; i < options.ops; ++i) {
+            int taskId = ids[random() % ids.size()];
+            auto start = Clock::now();
+            taskManager.getTaskById(taskId, sessionId);
+            gets.add(microsSince(start));
+        }
+        updates.reserve(options.ops);
+        for (size_t i = 0; i < options.ops; ++i) {
+            auto start = Clock::now();
+            taskManager.updateTask(ids[i], "Updated task " + std::to_string(i), "bench", "user0", false,
+                                   Priority::HIGH, false, sessionId);
+            updates.add(microsSince(start));
+        }
+        patches.reserve(options.ops);
+        for (size_t i = 0; i < options.ops; ++i) {
+            auto start = Clock::now();
+            taskManager.patchTask(ids[i], TaskPatch().setCompleted(true), sessionId);
+            patches.add(microsSince(start));
+        }
+        deletes.reserve(options.ops);
+        for (size_t i = 0; i < options.ops; ++i) {
+            auto start = Clock::now();
+            taskManager.deleteTask(ids[i], sessionId);
+            deletes.add(microsSince(start));
+        }
+
+        json.field("base_tasks", options.tasks);
+        json.field("durability", std::string(options.sync ? "sync" : "async"));
+        adds.write(json, "addTask");
+        gets.write(json, "getTaskById");
+        updates.write(json, "updateTask");
+        patches.write(json, "patchTask");
+        deletes.write(json, "deleteTask");
+    }
+    json.endObject();
+    removeWorkFiles();
+}
+
+// Calls list(sessionId) for random sessions for the given time and writes
+// the call and task throughput under key
+template <typename List>
+static void timeListing(const std::vector<int>& sessions, double seconds, List list,
+                        JsonWriter& json, const char* key) {
+    std::mt19937 random(7);
+    Samples latency;
+    size_t returned = 0;
+    auto start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < seconds * 1000.0) {
+        int sessionId = sessions[random() % sessions.size()];
+        auto call = Clock::now();
+        returned += list(sessionId).size();
+        latency.add(microsSince(call));
+        elapsed = millisSince(start);
+    }
+    json.beginObject(key);
+    json.field("calls_per_s", static_cast<double>(latency.size()) / (elapsed / 1000.0));
+    json.field("tasks_per_s", static_cast<double>(returned) / (elapsed / 1000.0));
+    json.field("tasks_per_call", static_cast<double>(returned) / static_cast<double>(latency.size()));
+    latency.write(json, "latency");
+    json.endObject();
+}
+
+static void runList(const Options& options, JsonWriter& json) {
+    std::cerr << "list: " << options.users << " users, " << options.tasks << " tasks" << std::endl;
+    removeWorkFiles();
+    writeUsers(options.users);
+    writeTasks(options.tasks, options.users);
+    json.beginObject("list");
+    {
+        TaskManager taskManager(TASKS_FILE, USERS_FILE);
+        std::vector<int> sessions = loginAll(taskManager, options.users);
+        json.field("users", options.users);
+        json.field("tasks", options.tasks);
+        timeListing(sessions, options.seconds / 2, [&](int sessionId) {
+            return taskManager.getPersonalTasks(sessionId);
+        }, json, "personal");
+        timeListing(sessions, options.seconds / 2, [&](int sessionId) {
+            return taskManager.getSharedTasks(sessionId);
+        }, json, "shared");
+    }
+    json.endObject();
+    removeWorkFiles();
+}
+
+// Each worker acts as one user on that user's own tasks. Reads are mostly
+// getTaskById with a personal listing every 16th read; writes are mostly
+// completion patches, plus full updates, adds and deletes of tasks the
+// worker added itself.
+static void runMixed(const Options& options, JsonWriter& json) {
+    const int users = std::max(16, options.threads);
+    removeWorkFiles();
+    writeUsers(users);
+    writeTasks(options.tasks, users);
+    json.beginObject("mixed");
+    json.field("tasks", options.tasks);
+    json.field("read_percent", options.readPercent);
+    json.field("durability", std::string(options.sync ? "sync" : "async"));
+    json.beginArray("runs");
+    {
+        TaskManager taskManager(TASKS_FILE, USERS_FILE);
+        taskManager.setDurability(options.sync ? Durability::SYNC : Durability::ASYNC);
+        std::vector<int> sessions = loginAll(taskManager, users);
+        const int tasksPerUser = std::max(1, options.tasks / users);
+
+        std::vector<int> threadCounts;
+        for (int count = 1; count < options.threads; count *= 2) {
+            threadCounts.push_back(count);
+        }
+        threadCounts.push_back(options.threads);
+
+        for (int threadCount : threadCounts) {
+            std::cerr << "mixed: " << threadCount << " threads" << std::endl;
+            std::atomic<bool> stop(false);
+            std::vector<Samples> reads(threadCount), writes(threadCount);
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threadCount; ++t) {
+                workers.emplace_back([&, t] {
+                    std::mt19937 random(static_cast<unsigned>(t + 1));
+                    int sessionId = sessions[t];
+                    std::string user = "user" + std::to_string(t);
+                    std::vector<int> added;
+                    size_t readCount = 0;
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        // Task ids congruent to t modulo users belong to this worker
+                        int taskId = t + users * static_cast<int>(random() % tasksPerUser);
+                        if (taskId == 0) {
+                            taskId = users;
+                        }
+                        bool read = static_cast<int>(random() % 100) < options.readPercent;
+                        unsigned kind = random() % 8;
+                        auto start = Clock::now();
+                        if (read) {
+                            if (++readCount % 16 == 0) {
+                                taskManager.getPersonalTasks(sessionId);
+                            } else {
+                                taskManager.getTaskById(taskId, sessionId);
+                            }
+                            reads[t].add(microsSince(start));
+                            continue;
+                        }
+                        if (kind < 5) {
+                            taskManager.patchTask(taskId, TaskPatch().setCompleted(kind % 2 == 0), sessionId);
+                        } else if (kind == 5) {
+                            taskManager.updateTask(taskId, "Mixed task", "mixed", user, false,
+                                                   Priority::LOW, false, sessionId);
+                        } else if (kind == 6 || added.empty()) {
+                            added.push_back(taskManager.addTask("Mixed task", "mixed", user,
+                                                                Priority::MEDIUM, false, sessionId));
+                        } else {
+                            taskManager.deleteTask(added.back(), sessionId);
+                            added.pop_back();
+                        }
+                        writes[t].add(microsSince(start));
+                    }
+                });
+            }
+            auto start = Clock::now();
+            std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+            stop = true;
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            double elapsed = millisSince(start) / 1000.0;
+
+            Samples allReads, allWrites;
+            for (int t = 0; t < threadCount; ++t) {
+                allReads.append(reads[t]);
+                allWrites.append(writes[t]);
+            }
+            json.beginObject();
+            json.field("threads", threadCount);
+            json.field("ops_per_s", static_cast<double>(allReads.size() + allWrites.size()) / elapsed);
+            allReads.write(json, "reads");
+            allWrites.write(json, "writes");
+            json.endObject();
+        }
+    }
+    json.endArray();
+    json.endObject();
+    removeWorkFiles();
+}
+
+static std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) {
+            comma = text.size();
+        }
+        if (comma > start) {
+            items.push_back(text.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+    return items;
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--quick") {
+            options.sizes = {10000};
+            options.ops = 2000;
+            options.users = 50;
+            options.tasks = 5000;
+            options.threads = 2;
+            options.seconds = 0.2;
+        } else if (arg == "--sync") {
+            options.sync = true;
+        } else if (arg == "--only" && hasValue) {
+            options.groups = splitList(argv[++i]);
+        } else if (arg == "--sizes" && hasValue) {
+            options.sizes.clear();
+            for (const auto& size : splitList(argv[++i])) {
+                options.sizes.push_back(std::atol(size.c_str()));
+            }
+        } else if (arg == "--ops" && hasValue) {
+            options.ops = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--users" && hasValue) {
+            options.users = std::atoi(argv[++i]);
+        } else if (arg == "--tasks" && hasValue) {
+            options.tasks = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (arg == "--read-percent" && hasValue) {
+            options.readPercent = std::atoi(argv[++i]);
+        } else if (arg == "--seconds" && hasValue) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (arg == "--out" && hasValue) {
+            options.outPath = argv[++i];
+        } else {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.ops == 0 || options.users < 1 || options.tasks < options.users || options.threads < 1 ||
+        options.readPercent < 0 || options.readPercent > 100 || options.seconds <= 0) {
+        std::cerr << "Invalid option value" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+    std::ofstream file;
+    if (!options.outPath.empty()) {
+        file.open(options.outPath, std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open " << options.outPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.outPath.empty() ? std::cout : file;
+
+    auto selected = [&options](const char* group) {
+        return std::find(options.groups.begin(), options.groups.end(), group) != options.groups.end();
+    };
+
+    JsonWriter json(out);
+    json.beginObject();
+    json.field("benchmark", std::string("taskbench"));
+    json.field("timestamp", static_cast<long long>(std::time(nullptr)));
+    json.field("hardware_threads", static_cast<int>(std::thread::hardware_concurrency()));
+#ifdef TASKMANAGER_METRICS
+    json.field("metrics_build", true);
+#else
+    json.field("metrics_build", false);
+#endif
+    if (selected("load")) {
+        runLoad(options, json);
+    }
+    if (selected("ops")) {
+        runOps(options, json);
+    }
+    if (selected("list")) {
+        runList(options, json);
+    }
+    if (selected("mixed")) {
+        runMixed(options, json);
+    }
+    json.endObject();
+    return out ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+// changefeed.h
+#ifndef CHANGEFEED_H
+#define CHANGEFEED_H
+
+#include "task.h"
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+enum class ChangeType : uint8_t { ADDED, UPDATED, DELETED };
+
+enum class ChangeStatus { OK, RESYNC, INVALID_SESSION };
+
+struct ChangeEvent {
+    uint64_t version;
+    ChangeType type;
+    // State after the change. DELETED events only carry the id.
+    Task task;
+    // Who could see the task before the change, so that subscribers who
+    // lose sight of it can be told to drop it
+    UserId previousAssignee;
+    bool previousShared;
+
+    ChangeEvent(ChangeType type, Task task, UserId previousAssignee, bool previousShared)
+        : version(0), type(type), task(std::move(task)), previousAssignee(previousAssignee),
+          previousShared(previousShared) {}
+};
+
+// Default number of events kept for subscribers that fall behind
+const size_t CHANGE_FEED_CAPACITY = 4096;
+
+// Bounded, versioned log of task mutations. Every published event gets the
+// next version number; subscribers read everything after the version they
+// last saw. Writers never wait for readers: once a reader falls more than
+// the capacity behind, its events are overwritten and it is told to resync
+// from a full listing instead. Versions start again from zero with the
+// process.
+class ChangeFeed {
+private:
+    mutable std::mutex mutex;
+    mutable std::condition_variable published;
+    std::vector<ChangeEvent> ring;
+    size_t capacity;
+    uint64_t version; // Last version published
+
+public:
+    explicit ChangeFeed(size_t capacity = CHANGE_FEED_CAPACITY)
+        : capacity(capacity == 0 ? 1 : capacity), version(0) {
+        ring.reserve(this->capacity);
+    }
+
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    // Call while the task's shard is still locked so that versions follow
+    // the order in which each task was changed
+    uint64_t publish(ChangeEvent event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        event.version = ++version;
+        if (ring.size() < capacity) {
+            ring.push_back(std::move(event));
+        } else {
+            ring[(event.version - 1) % capacity] = std::move(event);
+        }
+        published.notify_all();
+        return version;
+    }
+
+    uint64_t currentVersion() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return version;
+    }
+
+    // Copies up to maxEvents events newer than since, oldest first. Returns
+    // RESYNC when some of those events have already been overwritten, or
+    // when since is from a previous run.
+    ChangeStatus read(uint64_t since, size_t maxEvents, std::vector<ChangeEvent>& out) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t oldest = version - ring.size(); // Events after this are held
+        if (since < oldest || since > version) {
+            return ChangeStatus::RESYNC;
+        }
+        for (uint64_t v = since + 1; v <= version && maxEvents > 0; ++v, --maxEvents) {
+            out.push_back(ring[(v - 1) % capacity]);
+        }
+        return ChangeStatus::OK;
+    }
+
+    // Blocks until something newer than since is published or the timeout
+    // passes; returns whether there is anything to read
+    bool waitFor(uint64_t since, std::chrono::milliseconds timeout) const {
+        std::unique_lock<std::mutex> lock(mutex);
+        return published.wait_for(lock, timeout, [this, since] {
+            return version != since;
+        });
+    }
+};
+
+#endif // CHANGEFEED_H
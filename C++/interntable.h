@@ -0,0 +1,96 @@
+// interntable.h
+#ifndef INTERNTABLE_H
+#define INTERNTABLE_H
+
+#include <string>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <cstdint>
+
+const uint32_t NOT_INTERNED = 0xFFFFFFFFu;
+
+// Process-wide intern table giving every distinct string a small integer
+// handle; Tag keeps separate tables apart. Names are stored in fixed-size
+// chunks that never move, so resolving a handle back to its name takes no
+// lock and the returned reference stays valid for the life of the process.
+template <typename Tag>
+class InternTable {
+private:
+    static const size_t CHUNK_BITS = 12;
+    static const size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static const size_t MAX_CHUNKS = 4096;
+
+    std::atomic<std::string*> chunks[MAX_CHUNKS];
+    uint32_t count;
+    mutable std::shared_mutex indexMutex;
+    std::unordered_map<std::string, uint32_t> ids;
+
+    InternTable() : count(0) {
+        for (auto& chunk : chunks) {
+            chunk.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    InternTable(const InternTable&) = delete;
+    InternTable& operator=(const InternTable&) = delete;
+
+    ~InternTable() {
+        for (auto& chunk : chunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    static InternTable& instance() {
+        static InternTable names;
+        return names;
+    }
+
+    // Returns the handle for name, assigning one on first use
+    uint32_t intern(const std::string& name) {
+        {
+            std::shared_lock<std::shared_mutex> lock(indexMutex);
+            auto it = ids.find(name);
+            if (it != ids.end()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(indexMutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = count;
+        size_t chunk = id >> CHUNK_BITS;
+        if (chunk >= MAX_CHUNKS) {
+            throw std::runtime_error("Intern table is full");
+        }
+        std::string* names = chunks[chunk].load(std::memory_order_relaxed);
+        if (!names) {
+            names = new std::string[CHUNK_SIZE];
+        }
+        names[id & (CHUNK_SIZE - 1)] = name;
+        chunks[chunk].store(names, std::memory_order_release);
+        ids.emplace(name, id);
+        ++count;
+        return id;
+    }
+
+    // Returns the handle for name, or NOT_INTERNED if it was never interned
+    uint32_t find(const std::string& name) const {
+        std::shared_lock<std::shared_mutex> lock(indexMutex);
+        auto it = ids.find(name);
+        return it != ids.end() ? it->second : NOT_INTERNED;
+    }
+
+    // id must have been returned by intern()
+    const std::string& name(uint32_t id) const {
+        return chunks[id >> CHUNK_BITS].load(std::memory_order_acquire)[id & (CHUNK_SIZE - 1)];
+    }
+};
+
+#endif // INTERNTABLE_H
@@ -139,7 +139,7 @@ void handleUpdateTask(TaskManager& taskManager, int sessionId) {
     std::cin >> taskId;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     
-    Task* task = taskManager.getTaskById(taskId, sessionId);
+    auto task = taskManager.getTaskById(taskId, sessionId);
     if (!task) {
         std::cout << "Task not found or you don't have permission to update it.\n";
         std::cout << "Press Enter to continue...";
@@ -218,20 +218,10 @@ void handleCompleteTask(TaskManager& taskManager, int sessionId) {
     std::cin >> taskId;
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     
-    Task* task = taskManager.getTaskById(taskId, sessionId);
-    if (!task) {
-        std::cout << "Task not found or you don't have permission to update it.\n";
-        std::cout << "Press Enter to continue...";
-        std::cin.get();
-        return;
-    }
-    
-    if (taskManager.updateTask(taskId, task->getTitle(), task->getCategory(), 
-                              task->getAssignedTo(), true, task->getPriority(), 
-                              task->getIsShared(), sessionId)) {
+    if (taskManager.patchTask(taskId, TaskPatch().setCompleted(true), sessionId)) {
         std::cout << "Task marked as completed successfully.\n";
     } else {
-        std::cout << "Failed to update task.\n";
+        std::cout << "Task not found or you don't have permission to update it.\n";
     }
     
     std::cout << "Press Enter to continue...";
@@ -0,0 +1,74 @@
+// mappedfile.h
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+private:
+    const char* data;
+    size_t length;
+
+public:
+    MappedFile() : data(nullptr), length(0) {}
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    void open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        if (info.st_size == 0) {
+            ::close(fd);
+            return; // Nothing to map
+        }
+        void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Cannot map " + path);
+        }
+        data = static_cast<const char*>(mapped);
+        length = static_cast<size_t>(info.st_size);
+    }
+
+    void close() {
+        if (data) {
+            ::munmap(const_cast<char*>(data), length);
+        }
+        data = nullptr;
+        length = 0;
+    }
+
+    void adviseSequential() const {
+        if (data) {
+            ::madvise(const_cast<char*>(data), length, MADV_SEQUENTIAL);
+        }
+    }
+
+    const char* begin() const { return data; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(data, length); }
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,273 @@
+// metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <mutex>
+
+// Operation latency histograms and lock contention counters. Everything
+// here is recorded only when built with -DTASKMANAGER_METRICS; otherwise
+// OperationTimer is empty and acquire() just locks, so instrumented code
+// compiles to what it was without the instrumentation.
+
+enum class Operation {
+    LOGIN,
+    LOGOUT,
+    ADD_TASK,
+    UPDATE_TASK,
+    PATCH_TASK,
+    DELETE_TASK,
+    APPLY_BATCH,
+    GET_TASK,
+    LIST_TASKS,
+    QUERY_TASKS,
+    SEARCH_TASKS,
+    PENDING_BY_PRIORITY,
+    GET_CHANGES,
+    DURABILITY_WAIT,
+    JOURNAL_COMMIT,
+    COMPACT_JOURNAL,
+    WRITE_SNAPSHOT,
+    LOAD_TASKS,
+    SAVE_TASKS,
+    LOAD_USERS,
+    SAVE_USERS,
+    COUNT
+};
+
+enum class LockSite {
+    SHARD_WRITE,
+    SHARD_READ,
+    ALL_SHARDS_WRITE,
+    ALL_SHARDS_READ,
+    SESSIONS,
+    USERS,
+    COUNT
+};
+
+inline const char* operationName(Operation operation) {
+    static const char* const names[] = {
+        "login", "logout", "addTask", "updateTask", "patchTask", "deleteTask", "applyBatch",
+        "getTaskById", "listTasks", "queryTasks", "searchTasks", "getPendingByPriority",
+        "getChanges", "durabilityWait", "journalCommit", "compactJournal", "writeSnapshot",
+        "loadTasks", "saveTasks", "loadUsers", "saveUsers"
+    };
+    return names[static_cast<int>(operation)];
+}
+
+inline const char* lockSiteName(LockSite site) {
+    static const char* const names[] = {
+        "shardWrite", "shardRead", "allShardsWrite", "allShardsRead", "sessions", "users"
+    };
+    return names[static_cast<int>(site)];
+}
+
+#ifdef TASKMANAGER_METRICS
+
+// Lock-free latency histogram in nanoseconds. Buckets are log-linear as in
+// HdrHistogram: each power of two is split into 16 equal sub-buckets, so a
+// reported value is within 1/16 of the recorded one across the whole range.
+class LatencyHistogram {
+private:
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+
+    static int bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<int>(value);
+        }
+        int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    // Midpoint of a bucket's range
+    static uint64_t valueOf(int bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return static_cast<uint64_t>(bucket);
+        }
+        int shift = bucket / SUB_BUCKETS - 1;
+        uint64_t low = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+        return low + ((uint64_t(1) << shift) >> 1);
+    }
+
+public:
+    void record(uint64_t nanos) {
+        counts[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(nanos, std::memory_order_relaxed);
+        uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (nanos > seen && !maximum.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+
+    uint64_t mean() const {
+        uint64_t n = count();
+        return n ? sum.load(std::memory_order_relaxed) / n : 0;
+    }
+
+    // Value below which the given fraction of recordings fall. Concurrent
+    // recordings may or may not be counted.
+    uint64_t percentile(double fraction) const {
+        uint64_t n = count();
+        if (n == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(n - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            seen += counts[b].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(valueOf(b), max());
+            }
+        }
+        return max();
+    }
+};
+
+struct LockStats {
+    std::atomic<uint64_t> acquired{0};
+    std::atomic<uint64_t> contended{0}; // Acquisitions that had to wait
+    LatencyHistogram wait;               // Wait time of contended acquisitions
+};
+
+// Process-wide metrics, shared by every TaskManager
+class Metrics {
+private:
+    std::array<LatencyHistogram, static_cast<size_t>(Operation::COUNT)> operations;
+    std::array<LockStats, static_cast<size_t>(LockSite::COUNT)> locks;
+    std::chrono::steady_clock::time_point started;
+
+    Metrics() : started(std::chrono::steady_clock::now()) {}
+
+    static double micros(uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; }
+
+public:
+    static Metrics& instance() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    void recordOperation(Operation operation, uint64_t nanos) {
+        operations[static_cast<size_t>(operation)].record(nanos);
+    }
+
+    void recordLock(LockSite site, bool contended, uint64_t waitNanos) {
+        LockStats& stats = locks[static_cast<size_t>(site)];
+        stats.acquired.fetch_add(1, std::memory_order_relaxed);
+        if (contended) {
+            stats.contended.fetch_add(1, std::memory_order_relaxed);
+            stats.wait.record(waitNanos);
+        }
+    }
+
+    const LatencyHistogram& operation(Operation operation) const {
+        return operations[static_cast<size_t>(operation)];
+    }
+
+    // One line per operation or lock that has been used:
+    //   op|<name>|count=..|rate=..|mean_us=..|p50_us=..|p90_us=..|p99_us=..|p999_us=..|max_us=..
+    //   lock|<name>|acquired=..|contended=..|wait_p50_us=..|wait_p99_us=..|wait_max_us=..
+    void dump(std::ostream& out) const {
+        double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        out << std::fixed << std::setprecision(1);
+        out << "gauge|uptime_s|" << uptime << '\n';
+        for (size_t i = 0; i < operations.size(); ++i) {
+            const LatencyHistogram& histogram = operations[i];
+            uint64_t n = histogram.count();
+            if (n == 0) {
+                continue;
+            }
+            out << "op|" << operationName(static_cast<Operation>(i))
+                << "|count=" << n
+                << "|rate=" << (uptime > 0 ? static_cast<double>(n) / uptime : 0.0)
+                << "|mean_us=" << micros(histogram.mean())
+                << "|p50_us=" << micros(histogram.percentile(0.5))
+                << "|p90_us=" << micros(histogram.percentile(0.9))
+                << "|p99_us=" << micros(histogram.percentile(0.99))
+                << "|p999_us=" << micros(histogram.percentile(0.999))
+                << "|max_us=" << micros(histogram.max()) << '\n';
+        }
+        for (size_t i = 0; i < locks.size(); ++i) {
+            const LockStats& stats = locks[i];
+            uint64_t acquired = stats.acquired.load(std::memory_order_relaxed);
+            if (acquired == 0) {
+                continue;
+            }
+            out << "lock|" << lockSiteName(static_cast<LockSite>(i))
+                << "|acquired=" << acquired
+                << "|contended=" << stats.contended.load(std::memory_order_relaxed)
+                << "|wait_p50_us=" << micros(stats.wait.percentile(0.5))
+                << "|wait_p99_us=" << micros(stats.wait.percentile(0.99))
+                << "|wait_max_us=" << micros(stats.wait.max()) << '\n';
+        }
+        out.unsetf(std::ios::floatfield);
+    }
+};
+
+// Records the time from construction to destruction against an operation
+class OperationTimer {
+private:
+    Operation operation;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit OperationTimer(Operation operation)
+        : operation(operation), start(std::chrono::steady_clock::now()) {}
+
+    ~OperationTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::instance().recordOperation(
+            operation, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    OperationTimer(const OperationTimer&) = delete;
+    OperationTimer& operator=(const OperationTimer&) = delete;
+};
+
+// Returns a Lock (unique_lock or shared_lock) holding mutex. An uncontended
+// acquisition costs one try_lock; a contended one is timed.
+template <typename Lock, typename Mutex>
+Lock acquire(Mutex& mutex, LockSite site) {
+    Lock lock(mutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        Metrics::instance().recordLock(site, false, 0);
+        return lock;
+    }
+    auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    auto waited = std::chrono::steady_clock::now() - start;
+    Metrics::instance().recordLock(
+        site, true, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count()));
+    return lock;
+}
+
+#else
+
+class OperationTimer {
+public:
+    explicit OperationTimer(Operation) {}
+};
+
+template <typename Lock, typename Mutex>
+Lock acquire(Mutex& mutex, LockSite) {
+    return Lock(mutex);
+}
+
+#endif // TASKMANAGER_METRICS
+
+#endif // METRICS_H
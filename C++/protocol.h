@@ -0,0 +1,406 @@
+// protocol.h
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include "taskmanager.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <climits>
+#include <sstream>
+#include <algorithm>
+
+// Line-based request/response protocol spoken by the server. Requests and
+// responses are pipe-delimited like the data files, one per line:
+//
+//   LOGIN|<user>|<password>                                -> OK|<sessionId>
+//   LOGOUT|<sessionId>                                     -> OK
+//   ADD|<sessionId>|<title>|<category>|<assignee>|<priority>|<shared>
+//                                                          -> OK|<taskId>
+//   UPDATE|<sessionId>|<taskId>|<title>|<category>|<assignee>|<completed>|<priority>|<shared>
+//                                                          -> OK
+//   PATCH|<sessionId>|<taskId>|<key>=<value>...            -> OK
+//   COMPLETE|<sessionId>|<taskId>                          -> OK
+//   DELETE|<sessionId>|<taskId>                            -> OK
+//   GET|<sessionId>|<taskId>                               -> OK|1, then the task
+//   LIST|<sessionId>|personal|shared                       -> OK|<n>, then n tasks
+//   LIST|<sessionId>|personal|shared|<afterId>|<limit>     -> OK|<n>|<cursor>, then n tasks
+//   QUERY|<sessionId>[|<key>=<value>...]                   -> OK|<n>, then n tasks
+//   SEARCH|<sessionId>|<text>[|<limit>]                    -> OK|<n>, then n tasks
+//   VERSION|<sessionId>                                    -> OK|<version>
+//   CHANGES|<sessionId>|<since>                            -> OK|<version>|<n>, then n changes
+//   STATS|<sessionId>                                      -> OK|<n>, then n lines
+//
+// Priorities are 0 (low) to 2 (high), flags are 0 or 1, and tasks are sent
+// in the tasks.txt record format. Paged listings come back in id order,
+// at least one task per page; pass the returned cursor as the next afterId
+// until it is 0. Changes use the journal record format
+// (A|task, U|task, D|id); a client that fell too far behind gets
+// ERR|resync|<version> and must LIST again before polling from <version>.
+// QUERY keys are category, assignee, completed, priority, shared, from and
+// to (createdAt bounds, seconds), sort (id|created|priority|title), order
+// (asc|desc) and limit. SEARCH text matches whole words in titles and
+// categories, or word prefixes when followed by '*'; every word must match.
+// PATCH changes only the fields given: title, category, assignee,
+// completed, priority and shared. STATS lines are described at
+// TaskManager::dumpStats.
+// Failures answer ERR|<reason>.
+namespace protocol {
+
+inline std::vector<std::string_view> splitFields(std::string_view line) {
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (true) {
+        size_t pos = line.find('|', start);
+        if (pos == std::string_view::npos) {
+            fields.push_back(line.substr(start));
+            return fields;
+        }
+        fields.push_back(line.substr(start, pos - start));
+        start = pos + 1;
+    }
+}
+
+inline bool parseInt(std::string_view field, int& value) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+inline bool parseFlag(std::string_view field, bool& value) {
+    if (field != "0" && field != "1") {
+        return false;
+    }
+    value = field == "1";
+    return true;
+}
+
+inline bool parsePriority(std::string_view field, Priority& value) {
+    int number;
+    if (!parseInt(field, number) || number < 0 || number > static_cast<int>(Priority::HIGH)) {
+        return false;
+    }
+    value = static_cast<Priority>(number);
+    return true;
+}
+
+inline std::string ok() { return "OK\n"; }
+inline std::string ok(int value) { return "OK|" + std::to_string(value) + "\n"; }
+inline std::string error(const char* reason) { return std::string("ERR|") + reason + "\n"; }
+
+// Most changes returned by one CHANGES request; clients poll again from the
+// returned version for the rest
+const size_t MAX_CHANGES_PER_RESPONSE = 1024;
+
+// Default SEARCH result limit
+const int MAX_SEARCH_RESULTS = 100;
+
+inline bool parseVersion(std::string_view field, uint64_t& value) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+inline bool parseTime(std::string_view field, time_t& value) {
+    long long number;
+    auto result = std::from_chars(field.data(), field.data() + field.size(), number);
+    value = static_cast<time_t>(number);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+// Fills query from key=value fields; false on anything unrecognized
+inline bool parseQuery(const std::vector<std::string_view>& fields, size_t first, TaskQuery& query) {
+    for (size_t i = first; i < fields.size(); ++i) {
+        size_t equals = fields[i].find('=');
+        if (equals == std::string_view::npos) {
+            return false;
+        }
+        std::string_view key = fields[i].substr(0, equals);
+        std::string_view value = fields[i].substr(equals + 1);
+        bool flag;
+        Priority priority;
+        time_t time;
+        int limit;
+        if (key == "category") {
+            query.category = std::string(value);
+        } else if (key == "assignee") {
+            query.assignedTo = std::string(value);
+        } else if (key == "completed" && parseFlag(value, flag)) {
+            query.completed = flag;
+        } else if (key == "priority" && parsePriority(value, priority)) {
+            query.priority = priority;
+        } else if (key == "shared" && parseFlag(value, flag)) {
+            query.isShared = flag;
+        } else if (key == "from" && parseTime(value, time)) {
+            query.createdFrom = time;
+        } else if (key == "to" && parseTime(value, time)) {
+            query.createdTo = time;
+        } else if (key == "limit" && parseInt(value, limit) && limit >= 0) {
+            query.limit = static_cast<size_t>(limit);
+        } else if (key == "order" && (value == "asc" || value == "desc")) {
+            query.descending = value == "desc";
+        } else if (key == "sort" && value == "id") {
+            query.sortBy = SortField::ID;
+        } else if (key == "sort" && value == "created") {
+            query.sortBy = SortField::CREATED_AT;
+        } else if (key == "sort" && value == "priority") {
+            query.sortBy = SortField::PRIORITY;
+        } else if (key == "sort" && value == "title") {
+            query.sortBy = SortField::TITLE;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Fills patch from key=value fields; false on anything unrecognized
+inline bool parsePatch(const std::vector<std::string_view>& fields, size_t first, TaskPatch& patch) {
+    for (size_t i = first; i < fields.size(); ++i) {
+        size_t equals = fields[i].find('=');
+        if (equals == std::string_view::npos) {
+            return false;
+        }
+        std::string_view key = fields[i].substr(0, equals);
+        std::string_view value = fields[i].substr(equals + 1);
+        bool flag;
+        Priority priority;
+        if (key == "title") {
+            patch.setTitle(std::string(value));
+        } else if (key == "category") {
+            patch.setCategory(std::string(value));
+        } else if (key == "assignee") {
+            patch.setAssignedTo(std::string(value));
+        } else if (key == "completed" && parseFlag(value, flag)) {
+            patch.setCompleted(flag);
+        } else if (key == "priority" && parsePriority(value, priority)) {
+            patch.setPriority(priority);
+        } else if (key == "shared" && parseFlag(value, flag)) {
+            patch.setShared(flag);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Executes one request line and returns the complete response text
+inline std::string handleRequest(TaskManager& taskManager, std::string_view line) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    std::vector<std::string_view> fields = splitFields(line);
+    std::string_view command = fields[0];
+
+    if (command == "LOGIN") {
+        if (fields.size() != 3) {
+            return error("usage");
+        }
+        int sessionId = taskManager.login(std::string(fields[1]), std::string(fields[2]));
+        return sessionId != -1 ? ok(sessionId) : error("invalid credentials");
+    }
+
+    int sessionId;
+    if (fields.size() < 2 || !parseInt(fields[1], sessionId)) {
+        return command.empty() ? error("empty request") : error("usage");
+    }
+
+    if (command == "LOGOUT") {
+        return taskManager.logout(sessionId) ? ok() : error("unknown session");
+    }
+
+    if (command == "ADD") {
+        Priority priority;
+        bool isShared;
+        if (fields.size() != 7 || !parsePriority(fields[5], priority) || !parseFlag(fields[6], isShared)) {
+            return error("usage");
+        }
+        int taskId = taskManager.addTask(std::string(fields[2]), std::string(fields[3]),
+                                         std::string(fields[4]), priority, isShared, sessionId);
+        return taskId != -1 ? ok(taskId) : error("invalid session or not saved");
+    }
+
+    if (command == "UPDATE") {
+        int taskId;
+        bool completed, isShared;
+        Priority priority;
+        if (fields.size() != 9 || !parseInt(fields[2], taskId) || !parseFlag(fields[6], completed) ||
+            !parsePriority(fields[7], priority) || !parseFlag(fields[8], isShared)) {
+            return error("usage");
+        }
+        bool updated = taskManager.updateTask(taskId, std::string(fields[3]), std::string(fields[4]),
+                                              std::string(fields[5]), completed, priority, isShared,
+                                              sessionId);
+        return updated ? ok() : error("not found or not permitted");
+    }
+
+    if (command == "PATCH") {
+        int taskId;
+        TaskPatch patch;
+        if (fields.size() < 4 || !parseInt(fields[2], taskId) || !parsePatch(fields, 3, patch)) {
+            return error("usage");
+        }
+        bool updated = taskManager.patchTask(taskId, patch, sessionId);
+        return updated ? ok() : error("not found or not permitted");
+    }
+
+    if (command == "COMPLETE") {
+        int taskId;
+        if (fields.size() != 3 || !parseInt(fields[2], taskId)) {
+            return error("usage");
+        }
+        bool updated = taskManager.patchTask(taskId, TaskPatch().setCompleted(true), sessionId);
+        return updated ? ok() : error("not found or not permitted");
+    }
+
+    if (command == "DELETE") {
+        int taskId;
+        if (fields.size() != 3 || !parseInt(fields[2], taskId)) {
+            return error("usage");
+        }
+        return taskManager.deleteTask(taskId, sessionId) ? ok() : error("not found or not permitted");
+    }
+
+    if (command == "GET") {
+        int taskId;
+        if (fields.size() != 3 || !parseInt(fields[2], taskId)) {
+            return error("usage");
+        }
+        auto task = taskManager.getTaskById(taskId, sessionId);
+        if (!task) {
+            return error("not found or not permitted");
+        }
+        return ok(1) + task->serialize() + "\n";
+    }
+
+    if (command == "LIST") {
+        if (fields.size() != 3 && fields.size() != 5) {
+            return error("usage");
+        }
+        TaskView view;
+        if (fields[2] == "personal") {
+            view = TaskView::PERSONAL;
+        } else if (fields[2] == "shared") {
+            view = TaskView::SHARED;
+        } else {
+            return error("usage");
+        }
+        int afterId = 0;
+        int limit = INT_MAX;
+        if (fields.size() == 5 && (!parseInt(fields[3], afterId) || !parseInt(fields[4], limit) || limit <= 0)) {
+            return error("usage");
+        }
+
+        // Tasks are serialized straight from the store
+        std::string body;
+        int count = 0;
+        int cursor = taskManager.visitTasks(sessionId, view, afterId, static_cast<size_t>(limit),
+                                            [&body, &count](const StoredTask& task) {
+            body += task.serialize();
+            body += '\n';
+            ++count;
+        });
+        if (cursor == -1) {
+            return error("invalid session");
+        }
+        if (fields.size() == 3) {
+            return ok(count) + body;
+        }
+        return "OK|" + std::to_string(count) + "|" + std::to_string(cursor) + "\n" + body;
+    }
+
+    if (command == "QUERY") {
+        TaskQuery query;
+        if (!parseQuery(fields, 2, query)) {
+            return error("usage");
+        }
+        if (taskManager.getUserFromSession(sessionId) == NO_USER) {
+            return error("invalid session");
+        }
+        std::vector<Task> tasks = taskManager.queryTasks(sessionId, query);
+        std::string response = ok(static_cast<int>(tasks.size()));
+        for (const auto& task : tasks) {
+            response += task.serialize();
+            response += '\n';
+        }
+        return response;
+    }
+
+    if (command == "SEARCH") {
+        int limit = MAX_SEARCH_RESULTS;
+        if ((fields.size() != 3 && fields.size() != 4) ||
+            (fields.size() == 4 && (!parseInt(fields[3], limit) || limit < 0))) {
+            return error("usage");
+        }
+        if (taskManager.getUserFromSession(sessionId) == NO_USER) {
+            return error("invalid session");
+        }
+        std::vector<Task> tasks = taskManager.searchTasks(sessionId, std::string(fields[2]),
+                                                          static_cast<size_t>(limit));
+        std::string response = ok(static_cast<int>(tasks.size()));
+        for (const auto& task : tasks) {
+            response += task.serialize();
+            response += '\n';
+        }
+        return response;
+    }
+
+    if (command == "VERSION") {
+        if (taskManager.getUserFromSession(sessionId) == NO_USER) {
+            return error("invalid session");
+        }
+        return "OK|" + std::to_string(taskManager.getChangeVersion()) + "\n";
+    }
+
+    if (command == "STATS") {
+        if (fields.size() != 2) {
+            return error("usage");
+        }
+        if (taskManager.getUserFromSession(sessionId) == NO_USER) {
+            return error("invalid session");
+        }
+        std::ostringstream stats;
+        taskManager.dumpStats(stats);
+        std::string lines = stats.str();
+        return ok(static_cast<int>(std::count(lines.begin(), lines.end(), '\n'))) + lines;
+    }
+
+    if (command == "CHANGES") {
+        uint64_t since;
+        if (fields.size() != 3 || !parseVersion(fields[2], since)) {
+            return error("usage");
+        }
+        std::vector<ChangeEvent> events;
+        uint64_t version;
+        ChangeStatus status = taskManager.getChanges(sessionId, since, MAX_CHANGES_PER_RESPONSE,
+                                                     events, version);
+        if (status == ChangeStatus::INVALID_SESSION) {
+            return error("invalid session");
+        }
+        if (status == ChangeStatus::RESYNC) {
+            return "ERR|resync|" + std::to_string(version) + "\n";
+        }
+        std::string response = "OK|" + std::to_string(version) + "|" + std::to_string(events.size()) + "\n";
+        for (const auto& event : events) {
+            switch (event.type) {
+            case ChangeType::ADDED:
+                response += "A|" + event.task.serialize();
+                break;
+            case ChangeType::UPDATED:
+                response += "U|" + event.task.serialize();
+                break;
+            case ChangeType::DELETED:
+                response += "D|" + std::to_string(event.task.getId());
+                break;
+            }
+            response += '\n';
+        }
+        return response;
+    }
+
+    return error("unknown command");
+}
+
+} // namespace protocol
+
+#endif // PROTOCOL_H
@@ -0,0 +1,51 @@
+// server.cpp
+// Headless multi-client server: one shared TaskManager served over TCP.
+//
+// Build: g++ server.cpp -o todo_server -std=c++17 -pthread
+// Usage: ./todo_server [port] [worker threads] [listen address]
+#include "server.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+static Server* activeServer = nullptr;
+
+static void handleSignal(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int port = argc > 1 ? std::atoi(argv[1]) : 5555;
+    int workerCount = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+    std::string host = argc > 3 ? argv[3] : "127.0.0.1";
+    if (port <= 0 || port > 65535) {
+        std::cerr << "Invalid port\n";
+        return 2;
+    }
+    if (workerCount < 1) {
+        workerCount = 4;
+    }
+
+    TaskManager taskManager;
+    Server server(taskManager, static_cast<size_t>(workerCount));
+    if (!server.listen(host, static_cast<uint16_t>(port))) {
+        return 1;
+    }
+
+    activeServer = &server;
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "Listening on " << host << ":" << port << " with " << workerCount << " workers" << std::endl;
+    server.run();
+    activeServer = nullptr;
+    std::cout << "Shutting down" << std::endl;
+#ifdef TASKMANAGER_METRICS
+    taskManager.dumpStats(std::cout);
+#endif
+    return 0;
+}
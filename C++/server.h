@@ -0,0 +1,405 @@
+// server.h
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "taskmanager.h"
+#include "protocol.h"
+#include "threadpool.h"
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Longest request line accepted before the connection is dropped
+const size_t MAX_REQUEST_LINE = 64 * 1024;
+
+// Requests a client may pipeline ahead of their responses
+const size_t MAX_PENDING_REQUESTS = 1024;
+
+// Unsent response bytes past which a connection is paused: nothing more is
+// read from it or run for it until its client has caught up. A single
+// response may exceed this; it is still sent whole.
+const size_t OUTPUT_HIGH_WATER = 4 * 1024 * 1024;
+
+// Single-threaded epoll loop that owns every socket. Complete request lines
+// are handed to the worker pool; each connection has at most one job running
+// at a time, so its responses come back in request order. Workers queue
+// response bytes on the connection and wake the loop through an eventfd to
+// write them out.
+class Server {
+private:
+    struct Connection {
+        int fd;
+        std::string input; // Loop thread only
+
+        std::mutex mutex; // Guards everything below
+        std::deque<std::string> requests;
+        std::string output;
+        bool processing = false;
+        bool flushQueued = false;
+        uint32_t events = EPOLLIN | EPOLLRDHUP; // Registered with epoll
+        bool closed = false;
+
+        explicit Connection(int fd) : fd(fd) {}
+    };
+    typedef std::shared_ptr<Connection> ConnectionPtr;
+
+    TaskManager& taskManager;
+    int listenFd;
+    int epollFd;
+    int wakeFd;
+    std::atomic<bool> running;
+    std::unordered_map<int, ConnectionPtr> connections;
+
+    std::mutex readyMutex;
+    std::vector<ConnectionPtr> ready;
+
+    ThreadPool workers;
+
+    static bool setNonBlocking(int fd) {
+        int flags = ::fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    // Worker side: hand a connection with fresh output back to the loop
+    void queueFlush(const ConnectionPtr& connection) {
+        {
+            std::lock_guard<std::mutex> lock(readyMutex);
+            ready.push_back(connection);
+        }
+        wake();
+    }
+
+    // Runs on a worker until the connection has no requests left
+    void process(ConnectionPtr connection) {
+        while (true) {
+            std::string request;
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                if (connection->requests.empty() || connection->closed) {
+                    connection->processing = false;
+                    return;
+                }
+                request = std::move(connection->requests.front());
+                connection->requests.pop_front();
+            }
+
+            std::string response;
+            try {
+                response = protocol::handleRequest(taskManager, request);
+            } catch (const std::exception& e) {
+                std::cerr << "Request failed: " << e.what() << std::endl;
+                response = protocol::error("internal error");
+            }
+
+            bool needsFlush;
+            bool full;
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                connection->output += response;
+                needsFlush = !connection->flushQueued;
+                connection->flushQueued = true;
+                // The loop resumes the rest once the output drains
+                full = connection->output.size() > OUTPUT_HIGH_WATER;
+                if (full) {
+                    connection->processing = false;
+                }
+            }
+            if (needsFlush) {
+                queueFlush(connection);
+            }
+            if (full) {
+                return;
+            }
+        }
+    }
+
+    void closeConnection(const ConnectionPtr& connection) {
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            connection->closed = true;
+            connection->requests.clear();
+        }
+        ::close(connection->fd);
+        connections.erase(connection->fd);
+    }
+
+    void acceptConnections() {
+        while (true) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                return; // EAGAIN once the backlog is drained
+            }
+            int noDelay = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            if (!setNonBlocking(fd)) {
+                ::close(fd);
+                continue;
+            }
+            epoll_event event;
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.fd = fd;
+            if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+                ::close(fd);
+                continue;
+            }
+            connections.emplace(fd, std::make_shared<Connection>(fd));
+        }
+    }
+
+    void readRequests(const ConnectionPtr& connection) {
+        char buffer[16384];
+        ssize_t n = ::read(connection->fd, buffer, sizeof(buffer));
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+            closeConnection(connection);
+            return;
+        }
+        if (n < 0) {
+            return;
+        }
+
+        std::string& input = connection->input;
+        input.append(buffer, static_cast<size_t>(n));
+        std::vector<std::string> lines;
+        size_t start = 0;
+        size_t newline;
+        while ((newline = input.find('\n', start)) != std::string::npos) {
+            if (newline - start > MAX_REQUEST_LINE) {
+                closeConnection(connection);
+                return;
+            }
+            lines.emplace_back(input, start, newline - start);
+            start = newline + 1;
+        }
+        input.erase(0, start);
+        if (input.size() > MAX_REQUEST_LINE) {
+            closeConnection(connection);
+            return;
+        }
+        if (lines.empty()) {
+            return;
+        }
+
+        bool startJob;
+        bool overflow;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            for (auto& line : lines) {
+                connection->requests.push_back(std::move(line));
+            }
+            overflow = connection->requests.size() > MAX_PENDING_REQUESTS;
+            startJob = !overflow && !connection->processing && connection->output.size() <= OUTPUT_HIGH_WATER;
+            if (startJob) {
+                connection->processing = true;
+            }
+        }
+        if (overflow) {
+            closeConnection(connection);
+            return;
+        }
+        if (startJob) {
+            workers.submit([this, connection] { process(connection); });
+        }
+    }
+
+    void writeResponses(const ConnectionPtr& connection) {
+        bool resume = false;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            connection->flushQueued = false;
+            if (connection->closed) {
+                return;
+            }
+            flushOutput(*connection);
+            if (!connection->processing && !connection->requests.empty() &&
+                connection->output.size() <= OUTPUT_HIGH_WATER) {
+                connection->processing = true;
+                resume = true;
+            }
+        }
+        if (resume) {
+            workers.submit([this, connection] { process(connection); });
+        }
+    }
+
+    // Sends what the socket takes, then asks epoll for writability while
+    // output is left and for input only while the output is below the high
+    // water mark. Called with the connection's mutex held.
+    void flushOutput(Connection& connection) {
+        std::string& output = connection.output;
+        size_t written = 0;
+        while (written < output.size()) {
+            ssize_t n = ::send(connection.fd, output.data() + written, output.size() - written, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+        output.erase(0, written);
+
+        // A paused connection drops EPOLLRDHUP too, or a client that shut
+        // down its side would keep waking the loop; hangups still arrive
+        uint32_t events = 0;
+        if (output.size() <= OUTPUT_HIGH_WATER) {
+            events |= EPOLLIN | EPOLLRDHUP;
+        }
+        if (!output.empty()) {
+            events |= EPOLLOUT;
+        }
+        if (events != connection.events) {
+            epoll_event event;
+            event.events = events;
+            event.data.fd = connection.fd;
+            ::epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+            connection.events = events;
+        }
+    }
+
+    void drainReady() {
+        uint64_t count;
+        ssize_t ignored = ::read(wakeFd, &count, sizeof(count));
+        (void)ignored;
+        std::vector<ConnectionPtr> flushing;
+        {
+            std::lock_guard<std::mutex> lock(readyMutex);
+            flushing.swap(ready);
+        }
+        for (const auto& connection : flushing) {
+            writeResponses(connection);
+        }
+    }
+
+public:
+    Server(TaskManager& taskManager, size_t workerCount)
+        : taskManager(taskManager), listenFd(-1), epollFd(-1), wakeFd(-1), running(false),
+          workers(workerCount) {}
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    ~Server() {
+        for (auto& entry : connections) {
+            std::lock_guard<std::mutex> lock(entry.second->mutex);
+            entry.second->closed = true;
+        }
+        // Running jobs may still wake the loop, so let them finish before any fd closes
+        workers.shutdown();
+        for (auto& entry : connections) {
+            ::close(entry.first);
+        }
+        if (listenFd >= 0) ::close(listenFd);
+        if (wakeFd >= 0) ::close(wakeFd);
+        if (epollFd >= 0) ::close(epollFd);
+    }
+
+    bool listen(const std::string& host, uint16_t port) {
+        listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd < 0) {
+            std::cerr << "socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        int reuse = 1;
+        ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+            std::cerr << "Invalid listen address " << host << std::endl;
+            return false;
+        }
+        if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listenFd, SOMAXCONN) != 0 || !setNonBlocking(listenFd)) {
+            std::cerr << "listen: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        epollFd = ::epoll_create1(0);
+        wakeFd = ::eventfd(0, EFD_NONBLOCK);
+        if (epollFd < 0 || wakeFd < 0) {
+            std::cerr << "epoll: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+        event.data.fd = wakeFd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+        return true;
+    }
+
+    // Serves connections until stop() is called
+    void run() {
+        running = true;
+        epoll_event events[256];
+        while (running) {
+            int count = ::epoll_wait(epollFd, events, 256, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "epoll_wait: " << std::strerror(errno) << std::endl;
+                return;
+            }
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptConnections();
+                    continue;
+                }
+                if (fd == wakeFd) {
+                    drainReady();
+                    continue;
+                }
+                auto it = connections.find(fd);
+                if (it == connections.end()) {
+                    continue;
+                }
+                ConnectionPtr connection = it->second;
+                if (events[i].events & EPOLLIN) {
+                    readRequests(connection);
+                }
+                if (connections.count(fd) && (events[i].events & EPOLLOUT)) {
+                    writeResponses(connection);
+                }
+                if (connections.count(fd) && (events[i].events & (EPOLLERR | EPOLLHUP)) &&
+                    !(events[i].events & EPOLLIN)) {
+                    closeConnection(connection);
+                }
+            }
+        }
+    }
+
+    // Safe to call from a signal handler
+    void stop() {
+        running = false;
+        wake();
+    }
+};
+
+#endif // SERVER_H
@@ -2,24 +2,35 @@
 #ifndef SESSION_H
 #define SESSION_H
 
+#include "usernames.h"
+#include "timerwheel.h"
+
 #include <string>
 #include <ctime>
+#include <cstdint>
 
 class Session {
 private:
     int sessionId;
-    std::string username;
+    UserId userId;
     time_t loginTime;
+    uint32_t loginTick; // TaskManager session clock at login
+    TimerWheel::TimerId expiryTimer;
 
 public:
-    Session(int sessionId, const std::string& username)
-        : sessionId(sessionId), username(username) {
+    Session(int sessionId, UserId userId, uint32_t loginTick = 0)
+        : sessionId(sessionId), userId(userId), loginTick(loginTick),
+          expiryTimer(TimerWheel::NO_TIMER) {
         loginTime = time(nullptr);
     }
 
     int getSessionId() const { return sessionId; }
-    std::string getUsername() const { return username; }
+    UserId getUserId() const { return userId; }
+    const std::string& getUsername() const { return UserNames::instance().name(userId); }
     time_t getLoginTime() const { return loginTime; }
+    uint32_t getLoginTick() const { return loginTick; }
+    TimerWheel::TimerId getExpiryTimer() const { return expiryTimer; }
+    void setExpiryTimer(TimerWheel::TimerId timer) { expiryTimer = timer; }
 };
 
 #endif // SESSION_H
\ No newline at end of file
@@ -0,0 +1,204 @@
+// sessiontable.h
+#ifndef SESSIONTABLE_H
+#define SESSIONTABLE_H
+
+#include "usernames.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+// Open-addressing map from session id to user handle with wait-free lookups.
+// Each slot is a single 64-bit word packing (session id, user id), so a
+// reader sees either a whole entry or none. Logins and logouts serialize on
+// a writer mutex.
+//
+// Session ids are handed out sequentially, so a slot's home is simply the
+// id modulo the capacity. Logouts leave tombstones that later logins reuse,
+// and lookups stop after the longest displacement any insert has needed, so
+// misses stay cheap even once no empty slots remain. The table only grows,
+// doubling when half full; replaced tables are kept until destruction so
+// readers never touch freed memory, and their total size stays below that of
+// the live table.
+//
+// Beside each slot sits the tick its session was last used at, stored by
+// touch() on the request path and read by the expiry sweep. A touch that
+// races with a grow may land in the old table and be lost, which at worst
+// ends a session one idle period early after long inactivity before it.
+class SessionTable {
+private:
+    static const uint64_t EMPTY = 0;
+    static const uint64_t TOMBSTONE = ~uint64_t(0);
+
+    struct Table {
+        size_t mask;
+        std::atomic<size_t> maxProbe;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+        std::unique_ptr<std::atomic<uint32_t>[]> touched;
+
+        explicit Table(size_t capacity)
+            : mask(capacity - 1), maxProbe(0), slots(new std::atomic<uint64_t>[capacity]),
+              touched(new std::atomic<uint32_t>[capacity]) {
+            for (size_t i = 0; i < capacity; ++i) {
+                slots[i].store(EMPTY, std::memory_order_relaxed);
+                touched[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::atomic<Table*> current;
+    std::vector<std::unique_ptr<Table>> tables;
+    std::mutex writerMutex;
+    size_t live;
+
+    static uint64_t pack(int sessionId, UserId user) {
+        return (uint64_t(static_cast<uint32_t>(sessionId)) << 32) | user;
+    }
+
+    static bool holds(uint64_t word, int sessionId) {
+        return word != TOMBSTONE && (word >> 32) == static_cast<uint32_t>(sessionId);
+    }
+
+    // Index of the slot holding sessionId in table, or -1. The slot may be
+    // reused as soon as it is found, so callers decode the entry from word,
+    // the value that matched, rather than loading the slot again.
+    static long locate(const Table& table, int sessionId, uint64_t& word) {
+        size_t home = static_cast<uint32_t>(sessionId) & table.mask;
+        size_t maxProbe = table.maxProbe.load(std::memory_order_acquire);
+        for (size_t probe = 0; probe <= maxProbe; ++probe) {
+            size_t index = (home + probe) & table.mask;
+            word = table.slots[index].load(std::memory_order_acquire);
+            if (word == EMPTY) {
+                return -1;
+            }
+            if (holds(word, sessionId)) {
+                return static_cast<long>(index);
+            }
+        }
+        return -1;
+    }
+
+    // Must be called with writerMutex held
+    static void place(Table& table, uint64_t word, uint32_t touchedAt) {
+        size_t home = (word >> 32) & table.mask;
+        for (size_t probe = 0; ; ++probe) {
+            auto& slot = table.slots[(home + probe) & table.mask];
+            uint64_t existing = slot.load(std::memory_order_relaxed);
+            if (existing == EMPTY || existing == TOMBSTONE) {
+                table.touched[(home + probe) & table.mask].store(touchedAt, std::memory_order_relaxed);
+                slot.store(word, std::memory_order_release);
+                if (probe > table.maxProbe.load(std::memory_order_relaxed)) {
+                    table.maxProbe.store(probe, std::memory_order_release);
+                }
+                return;
+            }
+        }
+    }
+
+    // Must be called with writerMutex held
+    void grow() {
+        Table* old = current.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> bigger(new Table((old->mask + 1) * 2));
+        for (size_t i = 0; i <= old->mask; ++i) {
+            uint64_t word = old->slots[i].load(std::memory_order_relaxed);
+            if (word != EMPTY && word != TOMBSTONE) {
+                place(*bigger, word, old->touched[i].load(std::memory_order_relaxed));
+            }
+        }
+        current.store(bigger.get(), std::memory_order_release);
+        tables.push_back(std::move(bigger));
+    }
+
+public:
+    explicit SessionTable(size_t initialCapacity = 1024) : live(0) {
+        size_t capacity = 16;
+        while (capacity < initialCapacity) {
+            capacity *= 2;
+        }
+        tables.emplace_back(new Table(capacity));
+        current.store(tables.back().get(), std::memory_order_release);
+    }
+
+    SessionTable(const SessionTable&) = delete;
+    SessionTable& operator=(const SessionTable&) = delete;
+
+    // Wait-free: at most maxProbe + 1 atomic loads
+    UserId find(int sessionId) const {
+        if (sessionId <= 0) {
+            return NO_USER;
+        }
+        const Table* table = current.load(std::memory_order_acquire);
+        uint64_t word;
+        return locate(*table, sessionId, word) < 0 ? NO_USER : static_cast<UserId>(word);
+    }
+
+    // Like find, and records now as the session's last use. The store is
+    // skipped when the tick has not changed, so hot sessions do not keep
+    // writing the same cache line. If a logout and a new login reuse the
+    // slot meanwhile, the store is skipped as well; one that still slips in
+    // just after the reuse stamps the new session with the current tick,
+    // which is no older than its login.
+    UserId touch(int sessionId, uint32_t now) const {
+        if (sessionId <= 0) {
+            return NO_USER;
+        }
+        const Table* table = current.load(std::memory_order_acquire);
+        uint64_t word;
+        long index = locate(*table, sessionId, word);
+        if (index < 0) {
+            return NO_USER;
+        }
+        if (table->touched[index].load(std::memory_order_relaxed) != now &&
+            table->slots[index].load(std::memory_order_acquire) == word) {
+            table->touched[index].store(now, std::memory_order_relaxed);
+        }
+        return static_cast<UserId>(word);
+    }
+
+    // Tick of the session's last touch (or insert); false if it is unknown
+    bool lastTouched(int sessionId, uint32_t& tick) const {
+        const Table* table = current.load(std::memory_order_acquire);
+        uint64_t word;
+        long index = sessionId > 0 ? locate(*table, sessionId, word) : -1;
+        if (index < 0) {
+            return false;
+        }
+        tick = table->touched[index].load(std::memory_order_acquire);
+        // A reused slot's tick belongs to another session
+        return table->slots[index].load(std::memory_order_acquire) == word;
+    }
+
+    // sessionId must be positive and not already present
+    void insert(int sessionId, UserId user, uint32_t now = 0) {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        Table* table = current.load(std::memory_order_relaxed);
+        if ((live + 1) * 2 > table->mask + 1) {
+            grow();
+            table = current.load(std::memory_order_relaxed);
+        }
+        place(*table, pack(sessionId, user), now);
+        ++live;
+    }
+
+    bool erase(int sessionId) {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        Table* table = current.load(std::memory_order_relaxed);
+        uint64_t word;
+        long index = locate(*table, sessionId, word);
+        if (index < 0) {
+            return false;
+        }
+        table->slots[index].store(TOMBSTONE, std::memory_order_release);
+        --live;
+        return true;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        return live;
+    }
+};
+
+#endif // SESSIONTABLE_H
@@ -0,0 +1,214 @@
+// sha256.h
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+
+// SHA-256 (FIPS 180-4), with HMAC (RFC 2104) and PBKDF2 (RFC 8018) on top
+// for password hashing
+class Sha256 {
+public:
+    static const size_t DIGEST_SIZE = 32;
+    static const size_t BLOCK_SIZE = 64;
+    typedef std::array<uint8_t, DIGEST_SIZE> Digest;
+
+private:
+    uint32_t state[8];
+    uint8_t buffer[BLOCK_SIZE];
+    size_t buffered;
+    uint64_t length; // Bytes hashed so far
+
+    static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void compress(const uint8_t* block) {
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t(block[i * 4]) << 24) | (uint32_t(block[i * 4 + 1]) << 16) |
+                   (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t choose = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + choose + K[i] + w[i];
+            uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + majority;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+public:
+    Sha256() { reset(); }
+
+    void reset() {
+        static const uint32_t initial[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+        std::memcpy(state, initial, sizeof(state));
+        buffered = 0;
+        length = 0;
+    }
+
+    void update(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        length += size;
+        if (buffered > 0) {
+            size_t take = std::min(size, BLOCK_SIZE - buffered);
+            std::memcpy(buffer + buffered, bytes, take);
+            buffered += take;
+            bytes += take;
+            size -= take;
+            if (buffered < BLOCK_SIZE) {
+                return;
+            }
+            compress(buffer);
+            buffered = 0;
+        }
+        while (size >= BLOCK_SIZE) {
+            compress(bytes);
+            bytes += BLOCK_SIZE;
+            size -= BLOCK_SIZE;
+        }
+        std::memcpy(buffer, bytes, size);
+        buffered = size;
+    }
+
+    void update(std::string_view data) { update(data.data(), data.size()); }
+
+    // Pads and returns the digest; the object must be reset before reuse
+    Digest finish() {
+        uint64_t bits = length * 8;
+        uint8_t pad = 0x80;
+        update(&pad, 1);
+        uint8_t zero = 0;
+        while (buffered != BLOCK_SIZE - 8) {
+            update(&zero, 1);
+        }
+        uint8_t encoded[8];
+        for (int i = 0; i < 8; ++i) {
+            encoded[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        }
+        update(encoded, 8);
+
+        Digest digest;
+        for (int i = 0; i < 8; ++i) {
+            digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+            digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+            digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+            digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+        }
+        return digest;
+    }
+
+    static Digest hash(std::string_view data) {
+        Sha256 sha;
+        sha.update(data);
+        return sha.finish();
+    }
+};
+
+// Hash states with the HMAC inner and outer key pads already absorbed, so
+// each message costs only its own blocks
+class HmacSha256 {
+private:
+    Sha256 inner;
+    Sha256 outer;
+
+public:
+    explicit HmacSha256(std::string_view key) {
+        uint8_t block[Sha256::BLOCK_SIZE] = {};
+        if (key.size() > Sha256::BLOCK_SIZE) {
+            Sha256::Digest digest = Sha256::hash(key);
+            std::memcpy(block, digest.data(), digest.size());
+        } else {
+            std::memcpy(block, key.data(), key.size());
+        }
+        uint8_t pad[Sha256::BLOCK_SIZE];
+        for (size_t i = 0; i < Sha256::BLOCK_SIZE; ++i) {
+            pad[i] = block[i] ^ 0x36;
+        }
+        inner.update(pad, sizeof(pad));
+        for (size_t i = 0; i < Sha256::BLOCK_SIZE; ++i) {
+            pad[i] = block[i] ^ 0x5c;
+        }
+        outer.update(pad, sizeof(pad));
+    }
+
+    Sha256::Digest sign(const void* data, size_t size) const {
+        Sha256 message = inner;
+        message.update(data, size);
+        Sha256::Digest innerDigest = message.finish();
+        Sha256 result = outer;
+        result.update(innerDigest.data(), innerDigest.size());
+        return result.finish();
+    }
+
+    Sha256::Digest sign(std::string_view data) const { return sign(data.data(), data.size()); }
+};
+
+// Compares without an early exit, so timing reveals nothing about where
+// two digests differ
+inline bool digestsEqual(const Sha256::Digest& a, const Sha256::Digest& b) {
+    uint8_t difference = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        difference |= a[i] ^ b[i];
+    }
+    return difference == 0;
+}
+
+// PBKDF2-HMAC-SHA256 with a single 32-byte output block
+inline Sha256::Digest pbkdf2Sha256(std::string_view password, std::string_view salt, uint32_t iterations) {
+    HmacSha256 hmac(password);
+    std::string first(salt);
+    first.append("\0\0\0\1", 4); // Block index 1, big-endian
+    Sha256::Digest u = hmac.sign(first);
+    Sha256::Digest result = u;
+    for (uint32_t i = 1; i < iterations; ++i) {
+        u = hmac.sign(u.data(), u.size());
+        for (size_t b = 0; b < result.size(); ++b) {
+            result[b] ^= u[b];
+        }
+    }
+    return result;
+}
+
+#endif // SHA256_H
@@ -0,0 +1,238 @@
+// snapshot.h
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "task.h"
+#include "textparser.h"
+#include "mappedfile.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+
+enum class SnapshotFormat { TEXT, BINARY };
+
+// Binary snapshot layout, in host byte order:
+//   SnapshotHeader
+//   SnapshotRecord[taskCount]   fixed-width, one per task
+//   char heap[heapSize]         string bytes referenced by the records
+// Categories and assignees repeat across tasks, so each distinct string is
+// stored in the heap once.
+const char SNAPSHOT_MAGIC[4] = {'C', 'T', 'D', 'B'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t taskCount;
+    uint64_t heapSize;
+};
+
+struct SnapshotString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct SnapshotRecord {
+    int32_t id;
+    SnapshotString title;
+    SnapshotString category;
+    SnapshotString assignedTo;
+    uint8_t completed;
+    uint8_t priority;
+    uint8_t isShared;
+    uint8_t reserved;
+    int64_t createdAt;
+};
+
+static_assert(sizeof(SnapshotHeader) == 24, "SnapshotHeader layout changed");
+static_assert(sizeof(SnapshotRecord) == 40, "SnapshotRecord layout changed");
+
+// TaskList is any sized range of Task or StoredTask
+template <typename TaskList>
+bool writeBinarySnapshot(const std::string& path, const TaskList& tasks) {
+    std::string heap;
+    std::unordered_map<std::string, SnapshotString> shared;
+    auto store = [&heap](std::string_view value) {
+        SnapshotString ref = {static_cast<uint32_t>(heap.size()), static_cast<uint32_t>(value.size())};
+        heap.append(value.data(), value.size());
+        return ref;
+    };
+    auto storeShared = [&shared, &store](const std::string& value) {
+        auto it = shared.find(value);
+        if (it != shared.end()) {
+            return it->second;
+        }
+        SnapshotString ref = store(value);
+        shared.emplace(value, ref);
+        return ref;
+    };
+
+    std::vector<SnapshotRecord> records;
+    records.reserve(tasks.size());
+    for (const auto& task : tasks) {
+        SnapshotRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.id = task.getId();
+        record.title = store(task.getTitle());
+        record.category = storeShared(task.getCategory());
+        record.assignedTo = storeShared(task.getAssignedTo());
+        record.completed = task.isCompleted() ? 1 : 0;
+        record.priority = static_cast<uint8_t>(task.getPriority());
+        record.isShared = task.getIsShared() ? 1 : 0;
+        record.createdAt = static_cast<int64_t>(task.getCreatedAt());
+        records.push_back(record);
+    }
+    if (heap.size() > UINT32_MAX) {
+        std::cerr << "Task snapshot string heap exceeds 4 GiB" << std::endl;
+        return false;
+    }
+
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.taskCount = records.size();
+    header.heapSize = heap.size();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open binary snapshot for writing" << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()),
+               static_cast<std::streamsize>(records.size() * sizeof(SnapshotRecord)));
+    file.write(heap.data(), static_cast<std::streamsize>(heap.size()));
+    file.close();
+    return static_cast<bool>(file);
+}
+
+// Read-only memory mapping of a binary snapshot. Records and strings are
+// read in place; nothing is copied until a Task is materialized.
+class MappedSnapshot {
+private:
+    MappedFile file;
+    const SnapshotHeader* header;
+    const SnapshotRecord* records;
+    const char* heap;
+
+    bool validString(const SnapshotString& ref) const {
+        return uint64_t(ref.offset) + ref.length <= header->heapSize;
+    }
+
+    void fail(const std::string& reason) {
+        close();
+        throw std::runtime_error(reason);
+    }
+
+public:
+    MappedSnapshot() : header(nullptr), records(nullptr), heap(nullptr) {}
+
+    // Throws std::runtime_error if the file is not a well-formed snapshot
+    void open(const std::string& path) {
+        close();
+        file.open(path);
+        size_t length = file.size();
+        if (length < sizeof(SnapshotHeader)) {
+            fail("Snapshot too small");
+        }
+        const char* data = file.begin();
+        header = reinterpret_cast<const SnapshotHeader*>(data);
+        records = reinterpret_cast<const SnapshotRecord*>(data + sizeof(SnapshotHeader));
+
+        if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+            fail("Not a binary task snapshot");
+        }
+        if (header->version != SNAPSHOT_VERSION) {
+            fail("Unsupported snapshot version");
+        }
+        uint64_t recordBytes = header->taskCount * sizeof(SnapshotRecord);
+        if (header->taskCount > length / sizeof(SnapshotRecord) ||
+            sizeof(SnapshotHeader) + recordBytes + header->heapSize != length) {
+            fail("Snapshot size does not match its header");
+        }
+        heap = data + sizeof(SnapshotHeader) + recordBytes;
+        for (size_t i = 0; i < header->taskCount; ++i) {
+            const SnapshotRecord& record = records[i];
+            if (record.id < 0 || !validString(record.title) || !validString(record.category) ||
+                !validString(record.assignedTo) || record.priority > static_cast<uint8_t>(Priority::HIGH)) {
+                fail("Corrupt snapshot record " + std::to_string(i));
+            }
+        }
+        file.adviseSequential();
+    }
+
+    void close() {
+        file.close();
+        header = nullptr;
+        records = nullptr;
+        heap = nullptr;
+    }
+
+    size_t size() const { return header ? header->taskCount : 0; }
+    const SnapshotRecord& record(size_t index) const { return records[index]; }
+
+    std::string_view text(const SnapshotString& ref) const {
+        return std::string_view(heap + ref.offset, ref.length);
+    }
+
+    Task materialize(size_t index) const {
+        const SnapshotRecord& source = records[index];
+        Task task(source.id, std::string(text(source.title)), std::string(text(source.category)),
+                  std::string(text(source.assignedTo)), static_cast<Priority>(source.priority),
+                  source.isShared != 0);
+        task.setCompleted(source.completed != 0);
+        task.setCreatedAt(static_cast<time_t>(source.createdAt));
+        return task;
+    }
+};
+
+inline bool isBinarySnapshot(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
+
+// Converters between the binary snapshot and the pipe-delimited text format
+inline bool convertTextToBinary(const std::string& textPath, const std::string& binaryPath) {
+    std::ifstream file(textPath);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << textPath << std::endl;
+        return false;
+    }
+    file.close();
+    std::vector<Task> tasks;
+    parseTaskFile(textPath, [&tasks](Task&& task) {
+        tasks.push_back(std::move(task));
+    }, [&textPath](size_t lineNumber, const char* message) {
+        std::cerr << textPath << ":" << lineNumber << ": " << message << std::endl;
+    });
+    return writeBinarySnapshot(binaryPath, tasks);
+}
+
+inline bool convertBinaryToText(const std::string& binaryPath, const std::string& textPath) {
+    MappedSnapshot snapshot;
+    try {
+        snapshot.open(binaryPath);
+    } catch (const std::exception& e) {
+        std::cerr << binaryPath << ": " << e.what() << std::endl;
+        return false;
+    }
+    std::ofstream file(textPath, std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open " << textPath << " for writing" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        file << snapshot.materialize(i).serialize() << '\n';
+    }
+    file.close();
+    return static_cast<bool>(file);
+}
+
+#endif // SNAPSHOT_H
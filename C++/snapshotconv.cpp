@@ -0,0 +1,28 @@
+// snapshotconv.cpp
+// Converts task snapshots between the text and binary formats.
+//
+// Build: g++ snapshotconv.cpp -o snapshotconv -std=c++17
+// Usage: ./snapshotconv to-binary tasks.txt tasks.bin
+//        ./snapshotconv to-text tasks.bin tasks.txt
+#include "snapshot.h"
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " to-binary|to-text <input> <output>\n";
+        return 2;
+    }
+
+    std::string mode = argv[1];
+    bool ok;
+    if (mode == "to-binary") {
+        ok = convertTextToBinary(argv[2], argv[3]);
+    } else if (mode == "to-text") {
+        ok = convertBinaryToText(argv[2], argv[3]);
+    } else {
+        std::cerr << "Unknown mode: " << mode << "\n";
+        return 2;
+    }
+    return ok ? 0 : 1;
+}
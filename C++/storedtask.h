@@ -0,0 +1,68 @@
+// storedtask.h
+#ifndef STOREDTASK_H
+#define STOREDTASK_H
+
+#include "task.h"
+#include "interntable.h"
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <ctime>
+
+typedef uint32_t CategoryId;
+
+struct CategoryNamesTag {};
+typedef InternTable<CategoryNamesTag> CategoryNames;
+
+// Compact form of a Task as held by TaskStore. The category is interned
+// and the title points into the owning store's StringArena, so a stored
+// task is a fixed-size record (40 bytes on 64-bit) with no heap allocation
+// of its own. Only the store changes titles; everything else reads it like
+// a Task, and toTask() makes a self-contained copy for callers.
+class StoredTask {
+private:
+    friend class TaskStore;
+
+    int id;
+    UserId assignedTo;
+    CategoryId category;
+    uint32_t titleLength;
+    const char* title;
+    time_t createdAt;
+    bool completed;
+    Priority priority;
+    bool isShared;
+
+public:
+    int getId() const { return id; }
+    std::string_view getTitle() const { return std::string_view(title, titleLength); }
+    const std::string& getCategory() const { return CategoryNames::instance().name(category); }
+    CategoryId getCategoryId() const { return category; }
+    const std::string& getAssignedTo() const { return UserNames::instance().name(assignedTo); }
+    UserId getAssigneeId() const { return assignedTo; }
+    bool isCompleted() const { return completed; }
+    Priority getPriority() const { return priority; }
+    bool getIsShared() const { return isShared; }
+    time_t getCreatedAt() const { return createdAt; }
+
+    void setCategoryId(CategoryId newCategory) { category = newCategory; }
+    void setAssigneeId(UserId newAssignedTo) { assignedTo = newAssignedTo; }
+    void setCompleted(bool newCompleted) { completed = newCompleted; }
+    void setPriority(Priority newPriority) { priority = newPriority; }
+    void setShared(bool newShared) { isShared = newShared; }
+
+    std::string serialize() const {
+        return formatTaskRecord(id, getTitle(), getCategory(), getAssignedTo(), completed, priority,
+                                isShared, createdAt);
+    }
+
+    Task toTask() const {
+        Task task(id, std::string(getTitle()), getCategory(), assignedTo, priority, isShared);
+        task.setCompleted(completed);
+        task.setCreatedAt(createdAt);
+        return task;
+    }
+};
+
+#endif // STOREDTASK_H
@@ -0,0 +1,71 @@
+// stringarena.h
+#ifndef STRINGARENA_H
+#define STRINGARENA_H
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstring>
+
+// Bump allocator for immutable strings. Bytes are carved out of large
+// chunks that never move, so a stored view stays valid until the arena is
+// cleared or destroyed. Nothing is freed individually: release() only
+// counts the bytes as dead, and the owner rebuilds the arena into a fresh
+// one once enough of it is garbage.
+class StringArena {
+private:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    std::vector<std::unique_ptr<char[]>> large; // One string each
+    size_t chunkUsed;  // Bytes taken in chunks.back()
+    size_t liveBytes;
+    size_t deadBytes;
+
+public:
+    StringArena() : chunkUsed(CHUNK_SIZE), liveBytes(0), deadBytes(0) {}
+
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+
+    std::string_view store(std::string_view text) {
+        if (text.empty()) {
+            return std::string_view();
+        }
+        char* target;
+        if (text.size() > CHUNK_SIZE / 4) {
+            // Large strings get their own block so the open chunk's tail is
+            // not wasted
+            large.emplace_back(new char[text.size()]);
+            target = large.back().get();
+        } else {
+            if (chunkUsed + text.size() > CHUNK_SIZE) {
+                chunks.emplace_back(new char[CHUNK_SIZE]);
+                chunkUsed = 0;
+            }
+            target = chunks.back().get() + chunkUsed;
+            chunkUsed += text.size();
+        }
+        std::memcpy(target, text.data(), text.size());
+        liveBytes += text.size();
+        return std::string_view(target, text.size());
+    }
+
+    void release(std::string_view text) {
+        liveBytes -= text.size();
+        deadBytes += text.size();
+    }
+
+    void clear() {
+        chunks.clear();
+        large.clear();
+        chunkUsed = CHUNK_SIZE;
+        liveBytes = 0;
+        deadBytes = 0;
+    }
+
+    size_t live() const { return liveBytes; }
+    size_t garbage() const { return deadBytes; }
+};
+
+#endif // STRINGARENA_H
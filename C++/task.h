@@ -2,37 +2,79 @@
 #ifndef TASK_H
 #define TASK_H
 
+#include "usernames.h"
+
 #include <string>
-#include <vector>
+#include <string_view>
+#include <utility>
+#include <charconv>
+#include <stdexcept>
+#include <cstdint>
 #include <iostream>
 #include <ctime>
 
-enum class Priority { LOW, MEDIUM, HIGH };
+enum class Priority : uint8_t { LOW, MEDIUM, HIGH };
+
+// Pipe-delimited task record used by tasks.txt, the journal and the server
+inline std::string formatTaskRecord(int id, std::string_view title, std::string_view category,
+                                    std::string_view assignedTo, bool completed, Priority priority,
+                                    bool isShared, time_t createdAt) {
+    std::string record;
+    record.reserve(title.size() + category.size() + assignedTo.size() + 40);
+    record += std::to_string(id);
+    record += '|';
+    record += title;
+    record += '|';
+    record += category;
+    record += '|';
+    record += assignedTo;
+    record += completed ? "|1|" : "|0|";
+    record += std::to_string(static_cast<int>(priority));
+    record += isShared ? "|1|" : "|0|";
+    record += std::to_string(createdAt);
+    return record;
+}
 
 class Task {
 private:
     int id;
+    UserId assignedTo; // Interned in UserNames
     std::string title;
     std::string category;
-    std::string assignedTo;
+    time_t createdAt;
     bool completed;
     Priority priority;
     bool isShared;
-    time_t createdAt;
+
+    template <typename Number>
+    static Number parseNumber(std::string_view field) {
+        Number value;
+        auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+        if (result.ec != std::errc() || result.ptr != field.data() + field.size()) {
+            throw std::runtime_error("Invalid number in task data");
+        }
+        return value;
+    }
 
 public:
-    Task(int id, const std::string& title, const std::string& category, 
-         const std::string& assignedTo, Priority priority, bool isShared)
-        : id(id), title(title), category(category), assignedTo(assignedTo),
+    Task(int id, std::string title, std::string category, 
+         UserId assignedTo, Priority priority, bool isShared)
+        : id(id), assignedTo(assignedTo), title(std::move(title)), category(std::move(category)),
           completed(false), priority(priority), isShared(isShared) {
         createdAt = time(nullptr);
     }
 
+    Task(int id, std::string title, std::string category, 
+         const std::string& assignedTo, Priority priority, bool isShared)
+        : Task(id, std::move(title), std::move(category), UserNames::instance().intern(assignedTo),
+               priority, isShared) {}
+
     // Getters
     int getId() const { return id; }
-    std::string getTitle() const { return title; }
-    std::string getCategory() const { return category; }
-    std::string getAssignedTo() const { return assignedTo; }
+    const std::string& getTitle() const { return title; }
+    const std::string& getCategory() const { return category; }
+    const std::string& getAssignedTo() const { return UserNames::instance().name(assignedTo); }
+    UserId getAssigneeId() const { return assignedTo; }
     bool isCompleted() const { return completed; }
     Priority getPriority() const { return priority; }
     bool getIsShared() const { return isShared; }
@@ -41,10 +83,12 @@ public:
     // Setters
     void setTitle(const std::string& newTitle) { title = newTitle; }
     void setCategory(const std::string& newCategory) { category = newCategory; }
-    void setAssignedTo(const std::string& newAssignedTo) { assignedTo = newAssignedTo; }
+    void setAssignedTo(const std::string& newAssignedTo) { assignedTo = UserNames::instance().intern(newAssignedTo); }
+    void setAssigneeId(UserId newAssignedTo) { assignedTo = newAssignedTo; }
     void setCompleted(bool newCompleted) { completed = newCompleted; }
     void setPriority(Priority newPriority) { priority = newPriority; }
     void setShared(bool newShared) { isShared = newShared; }
+    void setCreatedAt(time_t newCreatedAt) { createdAt = newCreatedAt; }
 
     // Helper method to display priority as string
     std::string getPriorityString() const {
@@ -58,63 +102,64 @@ public:
 
     // Serialize task to string for file storage
     std::string serialize() const {
-        return std::to_string(id) + "|" + 
-               title + "|" + 
-               category + "|" + 
-               assignedTo + "|" + 
-               (completed ? "1" : "0") + "|" + 
-               std::to_string(static_cast<int>(priority)) + "|" + 
-               (isShared ? "1" : "0") + "|" + 
-               std::to_string(createdAt);
+        return formatTaskRecord(id, title, category, getAssignedTo(), completed, priority, isShared, createdAt);
     }
 
-    // Deserialize from string
-    static Task deserialize(const std::string& data) {
-        std::vector<std::string> parts;
-        std::string part;
-        size_t pos = 0;
-        std::string delimiter = "|";
-        std::string dataCopy = data;
-        
-        while ((pos = dataCopy.find(delimiter)) != std::string::npos) {
-            part = dataCopy.substr(0, pos);
-            parts.push_back(part);
-            dataCopy.erase(0, pos + delimiter.length());
+    // Parses one pipe-delimited record in place; only the string fields
+    // that end up in the Task are copied
+    static Task parse(std::string_view data) {
+        if (!data.empty() && data.back() == '\r') {
+            data.remove_suffix(1);
+        }
+
+        std::string_view parts[8];
+        size_t count = 0;
+        size_t start = 0;
+        while (count < 8) {
+            size_t pos = data.find('|', start);
+            if (pos == std::string_view::npos) {
+                parts[count++] = data.substr(start);
+                break;
+            }
+            parts[count++] = data.substr(start, pos - start);
+            start = pos + 1;
         }
-        parts.push_back(dataCopy); // Add the last part
         
-        if (parts.size() < 8) {
+        if (count < 8) {
             throw std::runtime_error("Invalid task data format");
         }
         
-        int id = std::stoi(parts[0]);
-        std::string title = parts[1];
-        std::string category = parts[2];
-        std::string assignedTo = parts[3];
-        bool completed = parts[4] == "1";
-        Priority priority = static_cast<Priority>(std::stoi(parts[5]));
-        bool isShared = parts[6] == "1";
-        time_t createdAt = std::stol(parts[7]);
+        int id = parseNumber<int>(parts[0]);
+        if (id < 0) {
+            throw std::runtime_error("Invalid task id");
+        }
+        int priority = parseNumber<int>(parts[5]);
+        if (priority < static_cast<int>(Priority::LOW) || priority > static_cast<int>(Priority::HIGH)) {
+            throw std::runtime_error("Invalid task priority");
+        }
         
-        Task task(id, title, category, assignedTo, priority, isShared);
-        task.setCompleted(completed);
-        // Set created time
+        Task task(id, std::string(parts[1]), std::string(parts[2]), std::string(parts[3]),
+                  static_cast<Priority>(priority), parts[6] == "1");
+        task.setCompleted(parts[4] == "1");
+        task.setCreatedAt(parseNumber<time_t>(parts[7]));
         return task;
     }
 
+    // Deserialize from string
+    static Task deserialize(const std::string& data) {
+        return parse(data);
+    }
+
     // Display task details
     void display() const {
         std::cout << "ID: " << id << "\n";
         std::cout << "Title: " << title << "\n";
         std::cout << "Category: " << category << "\n";
-        std::cout << "Assigned To: " << assignedTo << "\n";
+        std::cout << "Assigned To: " << getAssignedTo() << "\n";
         std::cout << "Status: " << (completed ? "Completed" : "Pending") << "\n";
         std::cout << "Priority: " << getPriorityString() << "\n";
         std::cout << "Type: " << (isShared ? "Shared" : "Personal") << "\n";
-        
-        char timeBuffer[26];
         std::cout << "Created At: " << std::ctime(&createdAt);
-        std::cout << "Created: " << timeBuffer;
         std::cout << "----------------------\n";
     }
 };
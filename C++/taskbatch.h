@@ -0,0 +1,65 @@
+// taskbatch.h
+#ifndef TASKBATCH_H
+#define TASKBATCH_H
+
+#include "task.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+enum class BatchOpType { ADD, UPDATE, DELETE };
+
+// One mutation of a batch. Adds ignore taskId and completed; deletes only
+// use taskId.
+struct BatchOp {
+    BatchOpType type;
+    int taskId;
+    std::string title;
+    std::string category;
+    std::string assignedTo;
+    bool completed;
+    Priority priority;
+    bool isShared;
+};
+
+// List of adds, updates and deletes for TaskManager::applyBatch, which
+// applies them in order and all or nothing. Tasks added by a batch get
+// their ids only when it is applied, so later operations of the same batch
+// can only refer to tasks that already exist.
+class TaskBatch {
+private:
+    std::vector<BatchOp> ops;
+    size_t addCount;
+
+public:
+    TaskBatch() : addCount(0) {}
+
+    void add(const std::string& title, const std::string& category,
+             const std::string& assignedTo, Priority priority, bool isShared) {
+        ops.push_back(BatchOp{BatchOpType::ADD, 0, title, category, assignedTo, false, priority, isShared});
+        ++addCount;
+    }
+
+    void update(int taskId, const std::string& title, const std::string& category,
+                const std::string& assignedTo, bool completed, Priority priority, bool isShared) {
+        ops.push_back(BatchOp{BatchOpType::UPDATE, taskId, title, category, assignedTo, completed, priority, isShared});
+    }
+
+    void remove(int taskId) {
+        ops.push_back(BatchOp{BatchOpType::DELETE, taskId, "", "", "", false, Priority::LOW, false});
+    }
+
+    void reserve(size_t count) { ops.reserve(count); }
+    void clear() {
+        ops.clear();
+        addCount = 0;
+    }
+
+    const std::vector<BatchOp>& getOps() const { return ops; }
+    size_t size() const { return ops.size(); }
+    size_t getAddCount() const { return addCount; }
+    bool empty() const { return ops.empty(); }
+};
+
+#endif // TASKBATCH_H
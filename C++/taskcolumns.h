@@ -0,0 +1,375 @@
+// taskcolumns.h
+#ifndef TASKCOLUMNS_H
+#define TASKCOLUMNS_H
+
+#include "storedtask.h"
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define TASKCOLUMNS_X86 1
+#endif
+
+// Filter and count kernels over task columns. Each kernel has a scalar
+// version and, on x86, SSE2 and AVX2 versions picked at run time. Masks hold
+// one bit per row, 64 rows per word; bits past the last row are zero.
+namespace columnkernels {
+
+inline size_t wordsFor(size_t rows) {
+    return (rows + 63) / 64;
+}
+
+#ifdef TASKCOLUMNS_X86
+inline bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+__attribute__((target("avx2")))
+inline void equalBytesAvx2(const uint8_t* column, size_t rows, uint8_t value, uint64_t* mask) {
+    const __m256i target = _mm256_set1_epi8(static_cast<char>(value));
+    size_t row = 0;
+    for (; row + 64 <= rows; row += 64) {
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + row));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + row + 32));
+        uint32_t lowBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, target)));
+        uint32_t highBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, target)));
+        mask[row / 64] &= uint64_t(lowBits) | (uint64_t(highBits) << 32);
+    }
+    if (row < rows) {
+        uint64_t bits = 0;
+        for (size_t i = row; i < rows; ++i) {
+            bits |= uint64_t(column[i] == value) << (i - row);
+        }
+        mask[row / 64] &= bits;
+    }
+}
+
+inline void equalBytesSse2(const uint8_t* column, size_t rows, uint8_t value, uint64_t* mask) {
+    const __m128i target = _mm_set1_epi8(static_cast<char>(value));
+    size_t row = 0;
+    for (; row + 64 <= rows; row += 64) {
+        uint64_t bits = 0;
+        for (int part = 0; part < 4; ++part) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + row + part * 16));
+            uint64_t partBits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target)));
+            bits |= partBits << (part * 16);
+        }
+        mask[row / 64] &= bits;
+    }
+    if (row < rows) {
+        uint64_t bits = 0;
+        for (size_t i = row; i < rows; ++i) {
+            bits |= uint64_t(column[i] == value) << (i - row);
+        }
+        mask[row / 64] &= bits;
+    }
+}
+
+__attribute__((target("avx2")))
+inline void equalU32Avx2(const uint32_t* column, size_t rows, uint32_t value, uint64_t* mask) {
+    const __m256i target = _mm256_set1_epi32(static_cast<int>(value));
+    size_t row = 0;
+    for (; row + 64 <= rows; row += 64) {
+        uint64_t bits = 0;
+        for (int part = 0; part < 8; ++part) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + row + part * 8));
+            __m256 equal = _mm256_castsi256_ps(_mm256_cmpeq_epi32(chunk, target));
+            bits |= uint64_t(static_cast<uint32_t>(_mm256_movemask_ps(equal))) << (part * 8);
+        }
+        mask[row / 64] &= bits;
+    }
+    if (row < rows) {
+        uint64_t bits = 0;
+        for (size_t i = row; i < rows; ++i) {
+            bits |= uint64_t(column[i] == value) << (i - row);
+        }
+        mask[row / 64] &= bits;
+    }
+}
+
+// Rows with from <= value < to; 64-bit compares need AVX2
+__attribute__((target("avx2")))
+inline void rangeI64Avx2(const int64_t* column, size_t rows, int64_t from, int64_t to, uint64_t* mask) {
+    const __m256i lower = _mm256_set1_epi64x(from);
+    const __m256i upper = _mm256_set1_epi64x(to);
+    size_t row = 0;
+    for (; row + 64 <= rows; row += 64) {
+        uint64_t bits = 0;
+        for (int part = 0; part < 16; ++part) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + row + part * 4));
+            __m256i inside = _mm256_andnot_si256(_mm256_cmpgt_epi64(lower, chunk), _mm256_cmpgt_epi64(upper, chunk));
+            bits |= uint64_t(static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(inside)))) << (part * 4);
+        }
+        mask[row / 64] &= bits;
+    }
+    if (row < rows) {
+        uint64_t bits = 0;
+        for (size_t i = row; i < rows; ++i) {
+            bits |= uint64_t(column[i] >= from && column[i] < to) << (i - row);
+        }
+        mask[row / 64] &= bits;
+    }
+}
+
+// Counts selected rows holding each priority in one pass over the column
+__attribute__((target("avx2,popcnt")))
+inline void countByPriorityAvx2(const uint8_t* column, size_t rows, const uint64_t* selected,
+                                std::array<size_t, 3>& counts) {
+    const __m256i values[3] = {_mm256_set1_epi8(0), _mm256_set1_epi8(1), _mm256_set1_epi8(2)};
+    size_t row = 0;
+    for (; row + 64 <= rows; row += 64) {
+        uint64_t chosen = selected[row / 64];
+        if (chosen == 0) {
+            continue;
+        }
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + row));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + row + 32));
+        for (int p = 0; p < 3; ++p) {
+            uint32_t lowBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, values[p])));
+            uint32_t highBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, values[p])));
+            counts[p] += static_cast<size_t>(_mm_popcnt_u64((uint64_t(lowBits) | (uint64_t(highBits) << 32)) & chosen));
+        }
+    }
+    for (; row < rows; ++row) {
+        if ((selected[row / 64] >> (row % 64)) & 1) {
+            ++counts[column[row]];
+        }
+    }
+}
+#endif
+
+inline void equalBytesScalar(const uint8_t* column, size_t rows, uint8_t value, uint64_t* mask) {
+    for (size_t word = 0; word < wordsFor(rows); ++word) {
+        uint64_t bits = 0;
+        size_t end = std::min(rows, word * 64 + 64);
+        for (size_t i = word * 64; i < end; ++i) {
+            bits |= uint64_t(column[i] == value) << (i % 64);
+        }
+        mask[word] &= bits;
+    }
+}
+
+inline void equalU32Scalar(const uint32_t* column, size_t rows, uint32_t value, uint64_t* mask) {
+    for (size_t word = 0; word < wordsFor(rows); ++word) {
+        uint64_t bits = 0;
+        size_t end = std::min(rows, word * 64 + 64);
+        for (size_t i = word * 64; i < end; ++i) {
+            bits |= uint64_t(column[i] == value) << (i % 64);
+        }
+        mask[word] &= bits;
+    }
+}
+
+inline void rangeI64Scalar(const int64_t* column, size_t rows, int64_t from, int64_t to, uint64_t* mask) {
+    for (size_t word = 0; word < wordsFor(rows); ++word) {
+        uint64_t bits = 0;
+        size_t end = std::min(rows, word * 64 + 64);
+        for (size_t i = word * 64; i < end; ++i) {
+            bits |= uint64_t(column[i] >= from && column[i] < to) << (i % 64);
+        }
+        mask[word] &= bits;
+    }
+}
+
+inline void countByPriorityScalar(const uint8_t* column, size_t rows, const uint64_t* selected,
+                                  std::array<size_t, 3>& counts) {
+    for (size_t word = 0; word < wordsFor(rows); ++word) {
+        uint64_t bits = selected[word];
+        while (bits) {
+            ++counts[column[word * 64 + __builtin_ctzll(bits)]];
+            bits &= bits - 1;
+        }
+    }
+}
+
+// mask &= (column == value)
+inline void equalBytes(const uint8_t* column, size_t rows, uint8_t value, uint64_t* mask) {
+#ifdef TASKCOLUMNS_X86
+    if (hasAvx2()) {
+        equalBytesAvx2(column, rows, value, mask);
+    } else {
+        equalBytesSse2(column, rows, value, mask);
+    }
+#else
+    equalBytesScalar(column, rows, value, mask);
+#endif
+}
+
+// mask &= (column == value)
+inline void equalU32(const uint32_t* column, size_t rows, uint32_t value, uint64_t* mask) {
+#ifdef TASKCOLUMNS_X86
+    if (hasAvx2()) {
+        equalU32Avx2(column, rows, value, mask);
+        return;
+    }
+#endif
+    equalU32Scalar(column, rows, value, mask);
+}
+
+// mask &= (from <= column < to)
+inline void rangeI64(const int64_t* column, size_t rows, int64_t from, int64_t to, uint64_t* mask) {
+#ifdef TASKCOLUMNS_X86
+    if (hasAvx2()) {
+        rangeI64Avx2(column, rows, from, to, mask);
+        return;
+    }
+#endif
+    rangeI64Scalar(column, rows, from, to, mask);
+}
+
+inline void countByPriority(const uint8_t* column, size_t rows, const uint64_t* selected,
+                            std::array<size_t, 3>& counts) {
+#ifdef TASKCOLUMNS_X86
+    if (hasAvx2()) {
+        countByPriorityAvx2(column, rows, selected, counts);
+        return;
+    }
+#endif
+    countByPriorityScalar(column, rows, selected, counts);
+}
+
+} // namespace columnkernels
+
+// Struct-of-arrays copy of a TaskStore's fixed-width fields, row for row
+// with its dense task array. Flags are packed one bit per row, so filters
+// and counts over them read a few bytes per task instead of whole Tasks.
+// Strings stay in the Tasks; category filters go through the index.
+class TaskColumns {
+private:
+    size_t rows;
+    std::vector<uint64_t> completed;
+    std::vector<uint64_t> shared;
+    std::vector<uint8_t> priority;
+    std::vector<int64_t> createdAt;
+    std::vector<uint32_t> assignee;
+
+    static void setBit(std::vector<uint64_t>& bits, size_t row, bool value) {
+        uint64_t bit = uint64_t(1) << (row % 64);
+        if (value) {
+            bits[row / 64] |= bit;
+        } else {
+            bits[row / 64] &= ~bit;
+        }
+    }
+
+    static bool getBit(const std::vector<uint64_t>& bits, size_t row) {
+        return (bits[row / 64] >> (row % 64)) & 1;
+    }
+
+public:
+    TaskColumns() : rows(0) {}
+
+    size_t size() const { return rows; }
+
+    void clear() {
+        rows = 0;
+        completed.clear();
+        shared.clear();
+        priority.clear();
+        createdAt.clear();
+        assignee.clear();
+    }
+
+    void reserve(size_t count) {
+        completed.reserve(columnkernels::wordsFor(count));
+        shared.reserve(columnkernels::wordsFor(count));
+        priority.reserve(count);
+        createdAt.reserve(count);
+        assignee.reserve(count);
+    }
+
+    void push(const StoredTask& task) {
+        if (rows % 64 == 0) {
+            completed.push_back(0);
+            shared.push_back(0);
+        }
+        priority.push_back(0);
+        createdAt.push_back(0);
+        assignee.push_back(0);
+        set(rows++, task);
+    }
+
+    void set(size_t row, const StoredTask& task) {
+        setBit(completed, row, task.isCompleted());
+        setBit(shared, row, task.getIsShared());
+        priority[row] = static_cast<uint8_t>(task.getPriority());
+        createdAt[row] = static_cast<int64_t>(task.getCreatedAt());
+        assignee[row] = task.getAssigneeId();
+    }
+
+    // Mirrors TaskStore's swap-remove: the last row moves into row
+    void remove(size_t row) {
+        size_t last = rows - 1;
+        if (row != last) {
+            setBit(completed, row, getBit(completed, last));
+            setBit(shared, row, getBit(shared, last));
+            priority[row] = priority[last];
+            createdAt[row] = createdAt[last];
+            assignee[row] = assignee[last];
+        }
+        setBit(completed, last, false);
+        setBit(shared, last, false);
+        priority.pop_back();
+        createdAt.pop_back();
+        assignee.pop_back();
+        if (--rows % 64 == 0) {
+            completed.pop_back();
+            shared.pop_back();
+        }
+    }
+
+    // A mask with every row selected
+    std::vector<uint64_t> allRows() const {
+        std::vector<uint64_t> mask(columnkernels::wordsFor(rows), ~uint64_t(0));
+        if (rows % 64 != 0) {
+            mask.back() = (uint64_t(1) << (rows % 64)) - 1;
+        }
+        return mask;
+    }
+
+    // Narrowing filters: each one clears the bits of rows that fail it
+    void whereCompleted(bool value, std::vector<uint64_t>& mask) const {
+        for (size_t w = 0; w < mask.size(); ++w) {
+            mask[w] &= value ? completed[w] : ~completed[w];
+        }
+    }
+
+    void whereShared(bool value, std::vector<uint64_t>& mask) const {
+        for (size_t w = 0; w < mask.size(); ++w) {
+            mask[w] &= value ? shared[w] : ~shared[w];
+        }
+    }
+
+    void wherePriority(Priority value, std::vector<uint64_t>& mask) const {
+        columnkernels::equalBytes(priority.data(), rows, static_cast<uint8_t>(value), mask.data());
+    }
+
+    void whereAssignee(UserId value, std::vector<uint64_t>& mask) const {
+        columnkernels::equalU32(assignee.data(), rows, value, mask.data());
+    }
+
+    void whereCreated(int64_t from, int64_t to, std::vector<uint64_t>& mask) const {
+        columnkernels::rangeI64(createdAt.data(), rows, from, to, mask.data());
+    }
+
+    // Keeps rows that are shared or assigned to userId
+    void whereVisibleTo(UserId userId, std::vector<uint64_t>& mask) const {
+        std::vector<uint64_t> mine = allRows();
+        whereAssignee(userId, mine);
+        for (size_t w = 0; w < mask.size(); ++w) {
+            mask[w] &= shared[w] | mine[w];
+        }
+    }
+
+    void countByPriority(const std::vector<uint64_t>& mask, std::array<size_t, 3>& counts) const {
+        columnkernels::countByPriority(priority.data(), rows, mask.data(), counts);
+    }
+};
+
+#endif // TASKCOLUMNS_H
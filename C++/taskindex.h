@@ -0,0 +1,212 @@
+// taskindex.h
+#ifndef TASKINDEX_H
+#define TASKINDEX_H
+
+#include "storedtask.h"
+#include "textindex.h"
+
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+
+// Growable bitset keyed by small non-negative integers
+class IdBitset {
+private:
+    std::vector<uint64_t> words;
+
+public:
+    void set(int id) {
+        size_t word = static_cast<size_t>(id) / 64;
+        if (word >= words.size()) {
+            words.resize(word + 1, 0);
+        }
+        words[word] |= uint64_t(1) << (id % 64);
+    }
+
+    void reset(int id) {
+        size_t word = static_cast<size_t>(id) / 64;
+        if (word < words.size()) {
+            words[word] &= ~(uint64_t(1) << (id % 64));
+        }
+    }
+
+    bool test(int id) const {
+        size_t word = static_cast<size_t>(id) / 64;
+        return word < words.size() && (words[word] >> (id % 64)) & 1;
+    }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : words) {
+            total += __builtin_popcountll(word);
+        }
+        return total;
+    }
+
+    void clear() { words.clear(); }
+
+    const std::vector<uint64_t>& getWords() const { return words; }
+
+    // Calls visit(id) for every set id in ascending order
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (size_t w = 0; w < words.size(); ++w) {
+            uint64_t bits = words[w];
+            while (bits) {
+                visit(static_cast<int>(w * 64 + __builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
+        }
+    }
+};
+
+// Secondary indexes over the task store, kept up to date on every mutation
+// so per-user and per-category lookups cost in proportion to their result.
+//
+// Like TaskStore, an index over every stride-th id (one shard of many) keys
+// its bitsets by id / stride, so they stay dense.
+class TaskIndex {
+private:
+    std::unordered_map<UserId, std::set<int>> byAssignee;
+    std::unordered_map<CategoryId, std::set<int>> byCategory;
+    std::set<int> shared;
+    IdBitset live;      // By slot
+    IdBitset completed; // By slot
+    TextIndex text;
+    int stride;
+    int residue; // Every id in the index is congruent to this modulo stride
+
+    int slotOf(int taskId) const { return taskId / stride; }
+    int idOf(int slot) const { return slot * stride + residue; }
+
+    static const std::set<int>& emptySet() {
+        static const std::set<int> empty;
+        return empty;
+    }
+
+    template <typename Key>
+    static void unlink(std::unordered_map<Key, std::set<int>>& index,
+                       const Key& key, int taskId) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second.erase(taskId);
+            if (it->second.empty()) {
+                index.erase(it);
+            }
+        }
+    }
+
+public:
+    explicit TaskIndex(int stride = 1) : stride(stride), residue(0) {}
+
+    void add(const StoredTask& task) {
+        int taskId = task.getId();
+        residue = taskId % stride;
+        byAssignee[task.getAssigneeId()].insert(taskId);
+        byCategory[task.getCategoryId()].insert(taskId);
+        if (task.getIsShared()) {
+            shared.insert(taskId);
+        }
+        live.set(slotOf(taskId));
+        if (task.isCompleted()) {
+            completed.set(slotOf(taskId));
+        }
+        text.add(task);
+    }
+
+    void remove(const StoredTask& task) {
+        int taskId = task.getId();
+        unlink(byAssignee, task.getAssigneeId(), taskId);
+        unlink(byCategory, task.getCategoryId(), taskId);
+        shared.erase(taskId);
+        live.reset(slotOf(taskId));
+        completed.reset(slotOf(taskId));
+        text.remove(task);
+    }
+
+    // Single-field updates for tasks already in the index
+    void reassign(int taskId, UserId from, UserId to) {
+        if (from != to) {
+            unlink(byAssignee, from, taskId);
+            byAssignee[to].insert(taskId);
+        }
+    }
+
+    void recategorize(int taskId, CategoryId from, CategoryId to) {
+        if (from != to) {
+            unlink(byCategory, from, taskId);
+            byCategory[to].insert(taskId);
+        }
+    }
+
+    void setShared(int taskId, bool isShared) {
+        if (isShared) {
+            shared.insert(taskId);
+        } else {
+            shared.erase(taskId);
+        }
+    }
+
+    void setCompleted(int taskId, bool isCompleted) {
+        if (isCompleted) {
+            completed.set(slotOf(taskId));
+        } else {
+            completed.reset(slotOf(taskId));
+        }
+    }
+
+    void addText(const StoredTask& task) { text.add(task); }
+    void removeText(const StoredTask& task) { text.remove(task); }
+
+    void clear() {
+        byAssignee.clear();
+        byCategory.clear();
+        shared.clear();
+        live.clear();
+        completed.clear();
+        text.clear();
+    }
+
+    const std::set<int>& assignedTo(UserId userId) const {
+        auto it = byAssignee.find(userId);
+        return it != byAssignee.end() ? it->second : emptySet();
+    }
+
+    const std::set<int>& inCategory(CategoryId category) const {
+        auto it = byCategory.find(category);
+        return it != byCategory.end() ? it->second : emptySet();
+    }
+
+    const std::set<int>& inCategory(const std::string& category) const {
+        return inCategory(CategoryNames::instance().find(category));
+    }
+
+    const std::set<int>& sharedTasks() const { return shared; }
+    const TextIndex& textIndex() const { return text; }
+
+    bool isCompleted(int taskId) const { return completed.test(slotOf(taskId)); }
+    size_t completedCount() const { return completed.count(); }
+    size_t pendingCount() const { return live.count() - completed.count(); }
+
+    template <typename Visitor>
+    void forEachCompleted(Visitor visit) const {
+        completed.forEach([this, &visit](int slot) { visit(idOf(slot)); });
+    }
+
+    template <typename Visitor>
+    void forEachPending(Visitor visit) const {
+        const std::vector<uint64_t>& liveWords = live.getWords();
+        const std::vector<uint64_t>& doneWords = completed.getWords();
+        for (size_t w = 0; w < liveWords.size(); ++w) {
+            uint64_t bits = liveWords[w] & ~(w < doneWords.size() ? doneWords[w] : 0);
+            while (bits) {
+                visit(idOf(static_cast<int>(w * 64 + __builtin_ctzll(bits))));
+                bits &= bits - 1;
+            }
+        }
+    }
+};
+
+#endif // TASKINDEX_H
@@ -0,0 +1,469 @@
+// taskjournal.h
+#ifndef TASKJOURNAL_H
+#define TASKJOURNAL_H
+
+#include "storedtask.h"
+#include "taskpatch.h"
+#include "textparser.h"
+#include "metrics.h"
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cerrno>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// How long a mutating call waits for its journal record to reach disk
+enum class Durability {
+    ASYNC, // Return as soon as the record is queued
+    SYNC   // Return once the batch holding the record has been fsynced
+};
+
+// Append-only log of task mutations, one record per line:
+//   A|<serialized task>   task added
+//   U|<serialized task>   task updated (full record)
+//   P|<task patch>        only the listed fields of a task changed
+//   D|<task id>           task deleted
+//   B|<n> ... E|<n>       the n records between are one batch
+// Records carry new values rather than changes to them, so replaying one
+// twice is harmless. A batch cut short by a crash is dropped whole on
+// replay.
+//
+// Appends only queue the record. A writer thread drains whatever has been
+// queued by all callers since its last pass and commits it with a single
+// write and fsync, so bursts of mutations share one disk flush. The users
+// journal is the same log carrying its own record kinds through append().
+//
+// A batch that fails to commit is cut off the log again and its records
+// reported as failed to their waiters; the batches after it are committed
+// as usual, so a transient disk error only fails the writes it hit. With
+// holdOnFailure set, the writer instead stops at the failed batch and fails
+// everything queued after it too, until releaseFailure() is called. That
+// lets a caller undo the failed changes before any record built on them
+// reaches disk.
+class TaskJournal {
+private:
+    // Failed sequence ranges remembered for waiters that have yet to check
+    static const size_t MAX_FAILED_RANGES = 64;
+
+    std::string logPath;
+    int fd;
+    bool tornTail; // A failed batch could not be cut off the end of the log
+    size_t recordCount;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::condition_variable commitCv;
+    std::string pending;
+    size_t pendingCount;
+    uint64_t lastQueued;
+    uint64_t lastCommitted;
+    std::vector<std::pair<uint64_t, uint64_t>> failedRanges; // Inclusive, in order
+    bool holdOnFailure;
+    uint64_t heldFrom; // First sequence of a held failure, or 0
+    bool stopWriter;
+    std::thread writer;
+
+    // Held by the writer while it touches fd, and by rotate/reset
+    std::mutex fileMutex;
+
+    static void formatRecord(std::string& out, char op, const std::string& payload) {
+        out += op;
+        out += '|';
+        out += payload;
+        out += '\n';
+    }
+
+    bool writeAll(const std::string& data) {
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        int synced;
+        do {
+            synced = ::fsync(fd);
+        } while (synced != 0 && errno == EINTR);
+        return synced == 0;
+    }
+
+    // Appends and syncs one batch; must be called with fileMutex held. On
+    // failure the log is truncated back to where the batch began, so the
+    // next batch does not follow a torn record. Should that fail too, the
+    // file is reopened and the next batch starts on a fresh line.
+    bool commit(std::string& batch) {
+        if (fd < 0 && !openFile()) {
+            return false;
+        }
+        if (tornTail) {
+            batch.insert(batch.begin(), '\n');
+        }
+        off_t start = ::lseek(fd, 0, SEEK_END);
+        if (start >= 0 && writeAll(batch)) {
+            tornTail = false;
+            return true;
+        }
+        if (start < 0 || ::ftruncate(fd, start) != 0 || ::fsync(fd) != 0) {
+            std::cerr << "Failed to cut a failed batch off journal " << logPath << std::endl;
+            closeFile();
+            tornTail = true;
+        }
+        return false;
+    }
+
+    // Must be called with queueMutex held
+    void recordFailure(uint64_t first, uint64_t last) {
+        if (!failedRanges.empty() && failedRanges.back().second + 1 >= first) {
+            failedRanges.back().second = std::max(failedRanges.back().second, last);
+            return;
+        }
+        failedRanges.emplace_back(first, last);
+        if (failedRanges.size() > MAX_FAILED_RANGES) {
+            failedRanges.erase(failedRanges.begin());
+        }
+    }
+
+    // Must be called with queueMutex held
+    bool failed(uint64_t sequence) const {
+        if (heldFrom != 0 && sequence >= heldFrom) {
+            return true;
+        }
+        for (const auto& range : failedRanges) {
+            if (sequence >= range.first && sequence <= range.second) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        while (true) {
+            queueCv.wait(lock, [this] { return (!pending.empty() && heldFrom == 0) || stopWriter; });
+            if (pending.empty() || heldFrom != 0) {
+                return; // Stopping with nothing left to commit
+            }
+
+            std::string batch;
+            batch.swap(pending);
+            size_t batchCount = pendingCount;
+            pendingCount = 0;
+            uint64_t batchStart = lastCommitted + 1;
+            uint64_t batchEnd = lastQueued;
+            lock.unlock();
+
+            bool ok;
+            {
+                OperationTimer timer(Operation::JOURNAL_COMMIT);
+                std::lock_guard<std::mutex> fileLock(fileMutex);
+                ok = commit(batch);
+            }
+            if (!ok) {
+                std::cerr << "Failed to commit journal batch to " << logPath << std::endl;
+            }
+
+            lock.lock();
+            if (!ok) {
+                recordFailure(batchStart, batchEnd);
+                recordCount -= std::min(recordCount, batchCount);
+                if (holdOnFailure) {
+                    heldFrom = batchStart;
+                }
+            }
+            lastCommitted = batchEnd;
+            commitCv.notify_all();
+        }
+    }
+
+    bool openFile() {
+        fd = ::open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            std::cerr << "Failed to open journal " << logPath << " for writing" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void closeFile() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+public:
+    // Records built up by the caller and queued in one go by appendBatch
+    class Batch {
+    private:
+        friend class TaskJournal;
+        std::string records;
+        size_t count = 0;
+
+        void addRecord(char op, const std::string& payload) {
+            formatRecord(records, op, payload);
+            ++count;
+        }
+
+    public:
+        void add(const StoredTask& task) { addRecord('A', task.serialize()); }
+        void update(const StoredTask& task) { addRecord('U', task.serialize()); }
+        void remove(int taskId) { addRecord('D', std::to_string(taskId)); }
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+    };
+
+    explicit TaskJournal(const std::string& logPath)
+        : logPath(logPath), fd(-1), tornTail(false), recordCount(0), pendingCount(0), lastQueued(0),
+          lastCommitted(0), holdOnFailure(false), heldFrom(0), stopWriter(false) {}
+
+    ~TaskJournal() {
+        close();
+    }
+
+    std::string getPath() const { return logPath; }
+    std::string getRotatedPath() const { return logPath + ".1"; }
+
+    size_t getRecordCount() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        return recordCount;
+    }
+
+    void setRecordCount(size_t count) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        recordCount = count;
+    }
+
+    bool open() {
+        if (writer.joinable()) {
+            return true;
+        }
+        // The writer runs either way and retries the file with each batch
+        bool opened = openFile();
+        stopWriter = false;
+        writer = std::thread(&TaskJournal::writerLoop, this);
+        return opened;
+    }
+
+    // Commits everything still queued, then stops the writer
+    void close() {
+        if (!writer.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopWriter = true;
+            queueCv.notify_one();
+        }
+        writer.join();
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+        closeFile();
+    }
+
+    // Each append returns a sequence number that can be passed to waitForCommit
+    uint64_t append(char op, const std::string& payload) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        formatRecord(pending, op, payload);
+        ++recordCount;
+        ++pendingCount;
+        queueCv.notify_one();
+        return ++lastQueued;
+    }
+
+    uint64_t appendAdd(const StoredTask& task) { return append('A', task.serialize()); }
+    uint64_t appendUpdate(const StoredTask& task) { return append('U', task.serialize()); }
+    uint64_t appendPatch(int taskId, const TaskPatch& patch) { return append('P', patch.serialize(taskId)); }
+    uint64_t appendDelete(int taskId) { return append('D', std::to_string(taskId)); }
+
+    // Queues the batch between begin and end markers as a single unit, so
+    // the writer commits it within one write
+    uint64_t appendBatch(const Batch& batch) {
+        std::string marker = std::to_string(batch.count);
+        std::lock_guard<std::mutex> lock(queueMutex);
+        formatRecord(pending, 'B', marker);
+        pending += batch.records;
+        formatRecord(pending, 'E', marker);
+        recordCount += batch.count;
+        pendingCount += batch.count;
+        queueCv.notify_one();
+        return ++lastQueued;
+    }
+
+    // Blocks until the batch holding the record numbered sequence has been
+    // committed. Returns false if that batch failed.
+    bool waitForCommit(uint64_t sequence) {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (!writer.joinable()) {
+            return false;
+        }
+        commitCv.wait(lock, [this, sequence] {
+            return lastCommitted >= sequence || (heldFrom != 0 && sequence >= heldFrom);
+        });
+        return !failed(sequence);
+    }
+
+    // True if the record numbered sequence is known not to have committed
+    bool hasFailed(uint64_t sequence) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        return failed(sequence);
+    }
+
+    void setHoldOnFailure(bool hold) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        holdOnFailure = hold;
+    }
+
+    bool isHoldingFailure() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        return heldFrom != 0;
+    }
+
+    // Drops every record queued since the held failure, reporting them as
+    // failed, and lets the writer carry on with later ones
+    void releaseFailure() {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (heldFrom == 0) {
+            return;
+        }
+        recordFailure(heldFrom, lastQueued);
+        recordCount -= std::min(recordCount, pendingCount);
+        pending.clear();
+        pendingCount = 0;
+        lastCommitted = lastQueued;
+        heldFrom = 0;
+        commitCv.notify_all();
+    }
+
+    bool flush() {
+        uint64_t sequence;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            sequence = lastQueued;
+        }
+        return waitForCommit(sequence);
+    }
+
+    // Moves the current log aside so that a snapshot can be written from it
+    // while new records keep going to a fresh log. The caller must stop new
+    // appends for the duration. A rotated log whose snapshot failed is kept
+    // rather than overwritten, and the live log left as it is; replaying
+    // its records over the next snapshot is harmless.
+    bool rotate() {
+        flush();
+        std::lock_guard<std::mutex> fileLock(fileMutex);
+        if (::access(getRotatedPath().c_str(), F_OK) == 0) {
+            return true;
+        }
+        closeFile();
+        bool renamed = std::rename(logPath.c_str(), getRotatedPath().c_str()) == 0;
+        if (!renamed) {
+            std::cerr << "Failed to rotate journal " << logPath << std::endl;
+        } else {
+            tornTail = false;
+        }
+        bool reopened = openFile();
+        if (renamed) {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            recordCount = 0;
+        }
+        return renamed && reopened;
+    }
+
+    void discardRotated() {
+        std::remove(getRotatedPath().c_str());
+    }
+
+    // Drops every record; only valid once a snapshot covers all of them.
+    // The caller must stop new appends for the duration.
+    void reset() {
+        flush();
+        {
+            std::lock_guard<std::mutex> fileLock(fileMutex);
+            if (fd >= 0) {
+                if (::ftruncate(fd, 0) != 0 || ::fsync(fd) != 0) {
+                    std::cerr << "Failed to truncate journal " << logPath << std::endl;
+                } else {
+                    tornTail = false;
+                }
+            } else {
+                std::ofstream truncated(logPath, std::ios::trunc);
+                if (truncated.is_open()) {
+                    tornTail = false;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        recordCount = 0;
+    }
+
+    // Calls handler(op, payload) for each record in the log at path and
+    // returns the number of records applied. A missing log has no records.
+    // The records of a batch are held back until its end marker is read.
+    template <typename Handler>
+    static size_t replay(const std::string& path, Handler handler) {
+        size_t applied = 0;
+        auto apply = [&](std::string_view line, size_t lineNumber) {
+            try {
+                handler(line[0], line.substr(2));
+                ++applied;
+            } catch (const std::exception& e) {
+                std::cerr << "Error replaying journal record at " << path << ":" << lineNumber
+                          << ": " << e.what() << std::endl;
+            }
+        };
+
+        std::string batch;
+        size_t batchLine = 0; // Line of the open batch's begin marker, or 0
+        forEachLine(path, [&](std::string_view line, size_t lineNumber) {
+            if (line.size() < 2 || line[1] != '|') {
+                std::cerr << "Skipping malformed journal record at " << path << ":" << lineNumber << std::endl;
+                return;
+            }
+            if (line[0] == 'B') {
+                if (batchLine != 0) {
+                    std::cerr << "Discarding unterminated batch at " << path << ":" << batchLine << std::endl;
+                }
+                batch.clear();
+                batchLine = lineNumber;
+            } else if (line[0] == 'E') {
+                if (batchLine == 0) {
+                    std::cerr << "Skipping stray batch end at " << path << ":" << lineNumber << std::endl;
+                    return;
+                }
+                forEachLineIn(batch, [&](std::string_view record, size_t offset) {
+                    apply(record, batchLine + offset);
+                });
+                batch.clear();
+                batchLine = 0;
+            } else if (batchLine != 0) {
+                batch.append(line.data(), line.size());
+                batch += '\n';
+            } else {
+                apply(line, lineNumber);
+            }
+        });
+        if (batchLine != 0) {
+            std::cerr << "Discarding incomplete batch at " << path << ":" << batchLine << std::endl;
+        }
+        return applied;
+    }
+};
+
+#endif // TASKJOURNAL_H
@@ -0,0 +1,97 @@
+// taskloader.h
+#ifndef TASKLOADER_H
+#define TASKLOADER_H
+
+#include "task.h"
+#include "taskshard.h"
+#include "textparser.h"
+#include "snapshot.h"
+#include "mappedfile.h"
+#include "threadpool.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <future>
+#include <algorithm>
+#include <utility>
+
+// Tasks parsed from one slice of a snapshot, already bucketed by shard so
+// that shards can then be filled in parallel without further coordination
+struct TaskChunk {
+    std::array<std::vector<Task>, TASK_SHARD_COUNT> byShard;
+    int maxId = 0;
+    size_t lines = 0;
+    std::vector<std::pair<size_t, std::string>> errors; // (line within chunk, message)
+
+    void add(Task&& task) {
+        maxId = std::max(maxId, task.getId());
+        byShard[shardOf(task.getId())].push_back(std::move(task));
+    }
+};
+
+// Slices smaller than this are not worth handing to another thread
+const size_t MIN_LOAD_CHUNK_BYTES = size_t(1) << 20;
+
+// Parses a text tasks file on the pool. The mapped file is cut into slices
+// on line boundaries and each slice is parsed by one job. Chunks come back in
+// file order so later lines still win over earlier ones with the same id.
+inline std::vector<TaskChunk> parseTaskTextParallel(const MappedFile& file, ThreadPool& pool) {
+    std::string_view text = file.view();
+    size_t sliceCount = std::max<size_t>(1, std::min(pool.size() * 4, text.size() / MIN_LOAD_CHUNK_BYTES));
+
+    std::vector<std::string_view> slices;
+    size_t start = 0;
+    for (size_t i = 1; i <= sliceCount && start < text.size(); ++i) {
+        size_t end = i == sliceCount ? text.size() : text.size() * i / sliceCount;
+        if (end < start) {
+            end = start;
+        }
+        end = text.find('\n', end);
+        end = end == std::string_view::npos ? text.size() : end + 1;
+        slices.push_back(text.substr(start, end - start));
+        start = end;
+    }
+
+    std::vector<TaskChunk> chunks(slices.size());
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < slices.size(); ++i) {
+        pending.push_back(pool.submit([&chunks, &slices, i] {
+            TaskChunk& chunk = chunks[i];
+            chunk.lines = forEachLineIn(slices[i], [&chunk](std::string_view line, size_t lineNumber) {
+                try {
+                    chunk.add(Task::parse(line));
+                } catch (const std::exception& e) {
+                    chunk.errors.emplace_back(lineNumber, e.what());
+                }
+            });
+        }));
+    }
+    for (auto& job : pending) {
+        job.get();
+    }
+    return chunks;
+}
+
+// Materializes a binary snapshot on the pool, one record range per job
+inline std::vector<TaskChunk> parseTaskSnapshotParallel(const MappedSnapshot& snapshot, ThreadPool& pool) {
+    size_t total = snapshot.size();
+    size_t rangeCount = std::max<size_t>(1, std::min(pool.size() * 4, total / 16384));
+    std::vector<TaskChunk> chunks(rangeCount);
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < rangeCount; ++i) {
+        pending.push_back(pool.submit([&chunks, &snapshot, i, total, rangeCount] {
+            TaskChunk& chunk = chunks[i];
+            for (size_t record = total * i / rangeCount; record < total * (i + 1) / rangeCount; ++record) {
+                chunk.add(snapshot.materialize(record));
+            }
+        }));
+    }
+    for (auto& job : pending) {
+        job.get();
+    }
+    return chunks;
+}
+
+#endif // TASKLOADER_H
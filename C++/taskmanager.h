@@ -4,272 +4,1481 @@
 
 #include "task.h"
 #include "user.h"
+#include "userdirectory.h"
 #include "session.h"
+#include "sessiontable.h"
+#include "timerwheel.h"
+#include "taskjournal.h"
+#include "atomicfile.h"
+#include "taskbatch.h"
+#include "taskpatch.h"
+#include "changefeed.h"
+#include "taskshard.h"
+#include "taskquery.h"
+#include "snapshot.h"
+#include "taskloader.h"
+#include "threadpool.h"
+#include "metrics.h"
 
 #include <vector>
 #include <map>
+#include <array>
+#include <set>
+#include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+
+enum class TaskView { PERSONAL, SHARED };
+
+// Session lifetimes unless changed with setSessionTimeouts
+const std::chrono::seconds DEFAULT_SESSION_IDLE_TIMEOUT(60 * 60);
+const std::chrono::seconds DEFAULT_SESSION_ABSOLUTE_TIMEOUT(24 * 60 * 60);
+
+// A journal with records is checkpointed at least this often
+const std::chrono::seconds DEFAULT_CHECKPOINT_INTERVAL(5 * 60);
 
 class TaskManager {
 private:
-    std::vector<Task> tasks;
-    std::vector<User> users;
+    std::array<TaskShard, TASK_SHARD_COUNT> shards;
+    UserDirectory users;
     std::map<int, Session> activeSessions;
-    int nextTaskId;
+    // Read-side index of activeSessions, looked up on every request
+    SessionTable sessionTable;
+    std::atomic<int> nextTaskId;
+    std::atomic<size_t> taskCount;
     int nextSessionId;
-    std::mutex taskMutex;
-    std::mutex userMutex;
+    std::mutex userMutex; // Orders user additions with the users file and its journal
+    // Users whose journal record is still being committed, with its
+    // sequence; the users file only takes them once it has. Guarded by
+    // userMutex.
+    std::unordered_map<std::string, uint64_t> uncommittedUsers;
     std::mutex sessionMutex;
+
+    // Session expiry. The sweeper thread advances a one-second session clock
+    // and the timer wheel; requests only record the clock's current tick as
+    // their session's last use. A timer that fires for a session used since
+    // it was armed is armed again for the session's new deadline.
+    std::chrono::steady_clock::time_point clockStart;
+    std::atomic<uint32_t> sessionClock;
+    std::atomic<uint32_t> idleTimeout;     // Seconds; 0 for none
+    std::atomic<uint32_t> absoluteTimeout; // Seconds since login; 0 for none
+    std::atomic<size_t> expiredSessions;
+    TimerWheel sessionTimers; // Guarded by sessionMutex
+    std::mutex sweeperMutex;
+    std::condition_variable sweeperCv;
+    bool stopSweeper;
+    std::thread sweeper;
     
     std::string tasksFilePath;
     std::string usersFilePath;
 
+    // Mutations are appended to the journal; the background compactor folds
+    // it into a fresh tasks snapshot once it grows as large as the task set,
+    // or once checkpointInterval has passed. Snapshots only ever replace the
+    // tasks file whole, so it is always the complete result of a checkpoint.
+    TaskJournal journal;
+    // New users are journaled the same way and folded into the users file
+    // by the same compactor
+    TaskJournal userJournal;
+    std::atomic<Durability> durability;
+    std::atomic<SnapshotFormat> snapshotFormat;
+    std::atomic<size_t> minCompactionRecords;
+    std::atomic<uint32_t> checkpointInterval; // Seconds; 0 for none
+    // Set when the tasks snapshot could not be read. A checkpoint would
+    // replace it with the partial state recovered from the journal, so none
+    // is written while the unreadable file waits, moved aside, for an
+    // operator to repair or remove it.
+    std::atomic<bool> checkpointsDisabled;
+    std::mutex checkpointMutex;
+    std::mutex compactionMutex;
+    std::condition_variable compactionCv;
+    bool compactionRequested;
+    bool userCompactionRequested;
+    bool stopCompactor;
+    std::thread compactor;
+
+    // Versioned deltas for collaborators, published under the shard lock
+    ChangeFeed changes;
+
+    // State before each SYNC mutation whose journal record is still being
+    // committed, keyed by its sequence. If the commit fails the change is
+    // undone, so a failed call leaves nothing behind in memory either.
+    struct UndoStep {
+        int taskId;
+        std::optional<Task> before; // Absent when the mutation added the task
+    };
+    std::map<uint64_t, std::vector<UndoStep>> pendingUndo;
+    std::mutex undoMutex;
+
+    TaskShard& shardFor(int taskId) {
+        return shards[shardOf(taskId)];
+    }
+
+    // Exclusive locks on every shard, always taken in shard order
+    std::vector<std::unique_lock<std::shared_mutex>> lockAllShards() {
+        std::vector<std::unique_lock<std::shared_mutex>> locks;
+        locks.reserve(shards.size());
+        for (auto& shard : shards) {
+            locks.push_back(acquire<std::unique_lock<std::shared_mutex>>(shard.mutex, LockSite::ALL_SHARDS_WRITE));
+        }
+        return locks;
+    }
+
+    // Shared locks on every shard, so readers see one consistent state
+    std::vector<std::shared_lock<std::shared_mutex>> lockAllShardsShared() {
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        locks.reserve(shards.size());
+        for (auto& shard : shards) {
+            locks.push_back(acquire<std::shared_lock<std::shared_mutex>>(shard.mutex, LockSite::ALL_SHARDS_READ));
+        }
+        return locks;
+    }
+
+    // Must be called with every shard locked, shared or exclusive
+    TaskStoreSnapshot captureTasks() const {
+        TaskStoreSnapshot snapshot;
+        snapshot.tasks.reserve(taskCount);
+        for (const auto& shard : shards) {
+            shard.tasks.snapshotInto(snapshot);
+        }
+        return snapshot;
+    }
+
+    void raiseNextTaskId(int taskId) {
+        int next = nextTaskId;
+        while (taskId >= next && !nextTaskId.compare_exchange_weak(next, taskId + 1)) {
+        }
+    }
+
+    // Must be called under the locks of the shards the steps touch, right
+    // after the mutation's record is appended
+    void recordUndo(uint64_t sequence, std::vector<UndoStep> steps) {
+        std::lock_guard<std::mutex> lock(undoMutex);
+        pendingUndo.emplace(sequence, std::move(steps));
+    }
+
+    // Puts a task back as it was before a failed mutation. Must be called
+    // with every shard locked.
+    void undo(const UndoStep& step) {
+        TaskShard& shard = shardFor(step.taskId);
+        const StoredTask* current = shard.tasks.find(step.taskId);
+        UserId previousAssignee = current ? current->getAssigneeId() : NO_USER;
+        bool previousShared = current && current->getIsShared();
+        if (current) {
+            shard.index.remove(*current);
+        }
+        if (!step.before) {
+            if (current) {
+                shard.tasks.erase(step.taskId);
+                --taskCount;
+                changes.publish(ChangeEvent(ChangeType::DELETED, Task(step.taskId, "", "", NO_USER, Priority::LOW, false),
+                                            previousAssignee, previousShared));
+            }
+            return;
+        }
+        const StoredTask& restored = shard.tasks.upsert(*step.before);
+        shard.index.add(restored);
+        if (!current) {
+            ++taskCount;
+        }
+        changes.publish(ChangeEvent(current ? ChangeType::UPDATED : ChangeType::ADDED, restored.toTask(),
+                                    previousAssignee, previousShared));
+    }
+
+    // Undoes every mutation whose record failed to commit, newest first,
+    // then lets the journal go on. The journal holds back records queued
+    // after a failure until then, so none built on an undone change lands.
+    void rollbackFailedMutations() {
+        auto locks = lockAllShards();
+        {
+            std::lock_guard<std::mutex> lock(undoMutex);
+            for (auto it = pendingUndo.end(); it != pendingUndo.begin();) {
+                --it;
+                if (!journal.hasFailed(it->first)) {
+                    continue;
+                }
+                for (auto step = it->second.rbegin(); step != it->second.rend(); ++step) {
+                    undo(*step);
+                }
+                it = pendingUndo.erase(it);
+            }
+        }
+        journal.releaseFailure();
+    }
+
+    // Called after the shard lock is released, so other writers can join the
+    // batch. mode is the durability the mutation was made under. In SYNC
+    // mode returns false if the record did not reach disk, in which case the
+    // mutation has been undone.
+    bool awaitDurability(uint64_t sequence, Durability mode) {
+        if (mode != Durability::SYNC) {
+            return true;
+        }
+        bool committed;
+        {
+            OperationTimer timer(Operation::DURABILITY_WAIT);
+            committed = journal.waitForCommit(sequence);
+        }
+        if (!committed) {
+            rollbackFailedMutations();
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(undoMutex);
+        pendingUndo.erase(sequence);
+        return true;
+    }
+
+    // Tick from which the session is no longer valid, or UINT64_MAX if it
+    // never expires. Must be called with sessionMutex held.
+    uint64_t sessionDeadline(const Session& session) const {
+        uint64_t deadline = UINT64_MAX;
+        uint32_t idle = idleTimeout;
+        uint32_t lastUse;
+        if (idle != 0 && sessionTable.lastTouched(session.getSessionId(), lastUse)) {
+            deadline = uint64_t(lastUse) + idle;
+        }
+        uint32_t absolute = absoluteTimeout;
+        if (absolute != 0) {
+            deadline = std::min(deadline, uint64_t(session.getLoginTick()) + absolute);
+        }
+        return deadline;
+    }
+
+    // Must be called with sessionMutex held
+    void armSessionTimer(Session& session) {
+        uint64_t deadline = sessionDeadline(session);
+        session.setExpiryTimer(deadline == UINT64_MAX ? TimerWheel::NO_TIMER
+                                                      : sessionTimers.arm(deadline, session.getSessionId()));
+    }
+
+    // Ends every session whose deadline has passed
+    void sweepSessions() {
+        auto elapsed = std::chrono::steady_clock::now() - clockStart;
+        uint32_t now = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(elapsed).count());
+        sessionClock.store(now, std::memory_order_relaxed);
+        auto lock = acquire<std::unique_lock<std::mutex>>(sessionMutex, LockSite::SESSIONS);
+        sessionTimers.advance(now, [this, now](uint64_t payload) {
+            auto it = activeSessions.find(static_cast<int>(payload));
+            if (it == activeSessions.end()) {
+                return;
+            }
+            if (sessionDeadline(it->second) <= now) {
+                sessionTable.erase(it->first);
+                activeSessions.erase(it);
+                ++expiredSessions;
+            } else {
+                armSessionTimer(it->second);
+            }
+        });
+    }
+
+    void sweeperLoop() {
+        std::unique_lock<std::mutex> lock(sweeperMutex);
+        while (!sweeperCv.wait_for(lock, std::chrono::seconds(1), [this] { return stopSweeper; })) {
+            lock.unlock();
+            sweepSessions();
+            lock.lock();
+        }
+    }
+
+    // Called after each journaled mutation. No compaction is requested
+    // while checkpoints are disabled; the periodic one reports the backlog.
+    void recordMutation() {
+        if (checkpointsDisabled || journal.getRecordCount() < std::max<size_t>(minCompactionRecords, taskCount)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(compactionMutex);
+        if (!compactionRequested) {
+            compactionRequested = true;
+            compactionCv.notify_one();
+        }
+    }
+
+    // Called after each journaled user addition. The journal only ever adds
+    // users, so it is folded in once it holds as many as the file it extends.
+    void recordUserMutation() {
+        size_t records = userJournal.getRecordCount();
+        if (records < minCompactionRecords || records * 2 < users.size()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(compactionMutex);
+        if (!userCompactionRequested) {
+            userCompactionRequested = true;
+            compactionCv.notify_one();
+        }
+    }
+
+    void compactionLoop() {
+        std::unique_lock<std::mutex> lock(compactionMutex);
+        while (true) {
+            uint32_t interval = checkpointInterval;
+            auto requested = [this, interval] {
+                return compactionRequested || userCompactionRequested || stopCompactor ||
+                       checkpointInterval != interval;
+            };
+            bool timedOut = false;
+            if (interval > 0) {
+                timedOut = !compactionCv.wait_for(lock, std::chrono::seconds(interval), requested);
+            } else {
+                compactionCv.wait(lock, requested);
+            }
+            if (stopCompactor) {
+                return;
+            }
+            bool tasksDue = compactionRequested || timedOut;
+            bool usersDue = userCompactionRequested;
+            lock.unlock();
+            if (tasksDue) {
+                compactJournal();
+            }
+            if (usersDue) {
+                saveUsers();
+            }
+            lock.lock();
+            compactionRequested = compactionRequested && !tasksDue;
+            userCompactionRequested = userCompactionRequested && !usersDue;
+        }
+    }
+
+    void compactJournal() {
+        OperationTimer timer(Operation::COMPACT_JOURNAL);
+        std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+        if (journal.getRecordCount() > 0) {
+            checkpoint();
+        }
+    }
+
+    // Copies every shard's task records under shared locks, so writers wait
+    // only for that copy and readers not at all, then serializes the copy
+    // with no shard lock held. The journal is rotated at the copy point, and
+    // the rotated log stays on disk until the snapshot covering it is in
+    // place. Must be called with checkpointMutex held.
+    bool checkpoint() {
+        if (checkpointsDisabled) {
+            std::cerr << "Checkpoint skipped until " << getQuarantinePath() << " is repaired or removed; "
+                      << journal.getRecordCount() << " journal records are waiting" << std::endl;
+            return false;
+        }
+        TaskStoreSnapshot snapshot;
+        {
+            auto locks = lockAllShardsShared();
+            if (!journal.rotate() || journal.isHoldingFailure()) {
+                return false; // Failed changes are still to be undone
+            }
+            snapshot = captureTasks();
+        }
+        // Titles replaced or deleted since the last checkpoint are freed here
+        for (auto& shard : shards) {
+            auto lock = acquire<std::unique_lock<std::shared_mutex>>(shard.mutex, LockSite::SHARD_WRITE);
+            shard.tasks.compactStrings();
+        }
+        if (!writeTasksSnapshot(snapshot)) {
+            return false;
+        }
+        journal.discardRotated();
+        return true;
+    }
+
+    bool writeTasksSnapshot(const TaskStoreSnapshot& snapshot) {
+        OperationTimer timer(Operation::WRITE_SNAPSHOT);
+        return replaceFile(tasksFilePath, [this, &snapshot](const std::string& tempPath) {
+            if (snapshotFormat == SnapshotFormat::BINARY) {
+                if (!writeBinarySnapshot(tempPath, snapshot)) {
+                    std::cerr << "Failed to write tasks snapshot" << std::endl;
+                    return false;
+                }
+                return true;
+            }
+
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file.is_open()) {
+                std::cerr << "Failed to open tasks file for writing" << std::endl;
+                return false;
+            }
+            for (const auto& task : snapshot) {
+                file << task.serialize() << '\n';
+            }
+            file.close();
+            if (!file) {
+                std::cerr << "Failed to write tasks snapshot" << std::endl;
+                return false;
+            }
+            return true;
+        });
+    }
+
+    // Writes the fields set in patch into a stored task; the caller keeps
+    // the index in step. Must be called with the task's shard locked.
+    static void writePatch(TaskStore& store, StoredTask& task, const TaskPatch& patch,
+                           UserId assignee, CategoryId categoryId) {
+        if (patch.has(TaskField::COMPLETED)) {
+            task.setCompleted(patch.isCompleted());
+        }
+        if (patch.has(TaskField::PRIORITY)) {
+            task.setPriority(patch.getPriority());
+        }
+        if (patch.has(TaskField::SHARED)) {
+            task.setShared(patch.getIsShared());
+        }
+        if (patch.has(TaskField::ASSIGNEE)) {
+            task.setAssigneeId(assignee);
+        }
+        if (patch.has(TaskField::CATEGORY)) {
+            task.setCategoryId(categoryId);
+        }
+        if (patch.has(TaskField::TITLE)) {
+            store.setTitle(task, patch.getTitle());
+        }
+        store.refresh(task.getId());
+    }
+
+    // Must be called with every shard locked
+    void applyJournalRecord(char op, std::string_view payload) {
+        if (op == 'D') {
+            int taskId;
+            auto result = std::from_chars(payload.data(), payload.data() + payload.size(), taskId);
+            if (result.ec != std::errc()) {
+                throw std::runtime_error("Invalid task id in journal");
+            }
+            shardFor(taskId).tasks.erase(taskId);
+            return;
+        }
+        if (op == 'P') {
+            int taskId;
+            TaskPatch patch = TaskPatch::parse(payload, taskId);
+            TaskStore& store = shardFor(taskId).tasks;
+            StoredTask* task = store.find(taskId);
+            if (!task) {
+                throw std::runtime_error("Patch for unknown task");
+            }
+            UserId assignee = patch.has(TaskField::ASSIGNEE) ? UserNames::instance().intern(patch.getAssignedTo()) : NO_USER;
+            CategoryId categoryId = patch.has(TaskField::CATEGORY) ? CategoryNames::instance().intern(patch.getCategory()) : NOT_INTERNED;
+            writePatch(store, *task, patch, assignee, categoryId);
+            return;
+        }
+        if (op != 'A' && op != 'U') {
+            throw std::runtime_error("Unknown journal record type");
+        }
+
+        Task task = Task::parse(payload);
+        raiseNextTaskId(task.getId());
+        shardFor(task.getId()).tasks.upsert(task);
+    }
+
 public:
     TaskManager(const std::string& tasksFile = "tasks.txt", 
                 const std::string& usersFile = "users.txt")
-        : nextTaskId(1), nextSessionId(1), 
-          tasksFilePath(tasksFile), usersFilePath(usersFile) {
-        loadUsers();
+        : nextTaskId(1), taskCount(0), nextSessionId(1),
+          clockStart(std::chrono::steady_clock::now()), sessionClock(0),
+          idleTimeout(static_cast<uint32_t>(DEFAULT_SESSION_IDLE_TIMEOUT.count())),
+          absoluteTimeout(static_cast<uint32_t>(DEFAULT_SESSION_ABSOLUTE_TIMEOUT.count())),
+          expiredSessions(0), stopSweeper(false),
+          tasksFilePath(tasksFile), usersFilePath(usersFile),
+          journal(tasksFile + ".log"), userJournal(usersFile + ".log"), durability(Durability::SYNC),
+          snapshotFormat(SnapshotFormat::TEXT),
+          minCompactionRecords(1024),
+          checkpointInterval(static_cast<uint32_t>(DEFAULT_CHECKPOINT_INTERVAL.count())),
+          checkpointsDisabled(false),
+          compactionRequested(false), userCompactionRequested(false), stopCompactor(false) {
+        // Users and tasks live in separate files and load side by side
+        std::thread userLoader(&TaskManager::loadUsers, this);
         loadTasks();
+        userLoader.join();
+        journal.setHoldOnFailure(true);
+        journal.open();
+        userJournal.open();
+        compactor = std::thread(&TaskManager::compactionLoop, this);
+        sweeper = std::thread(&TaskManager::sweeperLoop, this);
     }
 
     ~TaskManager() {
-        saveTasks();
-        saveUsers();
+        {
+            std::lock_guard<std::mutex> lock(sweeperMutex);
+            stopSweeper = true;
+            sweeperCv.notify_one();
+        }
+        sweeper.join();
+        {
+            std::lock_guard<std::mutex> lock(compactionMutex);
+            stopCompactor = true;
+            compactionCv.notify_one();
+        }
+        compactor.join();
+        // Both journals already hold every change, so shutdown only commits
+        // what is still queued; the next start replays it
+        journal.close();
+        userJournal.close();
+    }
+
+    // SYNC (the default) makes mutating calls return only once their journal
+    // record is on disk; one that fails to get there is undone and the call
+    // reports failure. ASYNC returns as soon as the record is queued.
+    void setDurability(Durability mode) {
+        durability = mode;
+        // Only SYNC callers wait to undo a failed change; in ASYNC mode it is
+        // kept and reaches disk with the next checkpoint
+        journal.setHoldOnFailure(mode == Durability::SYNC);
+    }
+
+    // Format of snapshots written from now on. Loading a binary snapshot
+    // switches this to BINARY so the file keeps its format.
+    void setSnapshotFormat(SnapshotFormat format) {
+        snapshotFormat = format;
+    }
+
+    // Sessions end once unused for idle, or once absolute has passed since
+    // login; zero disables either limit. Both are checked once a second, off
+    // the request path, and apply to existing sessions too.
+    void setSessionTimeouts(std::chrono::seconds idle, std::chrono::seconds absolute) {
+        idleTimeout = static_cast<uint32_t>(idle.count());
+        absoluteTimeout = static_cast<uint32_t>(absolute.count());
+        auto lock = acquire<std::unique_lock<std::mutex>>(sessionMutex, LockSite::SESSIONS);
+        for (auto& entry : activeSessions) {
+            sessionTimers.cancel(entry.second.getExpiryTimer());
+            armSessionTimer(entry.second);
+        }
+    }
+
+    // Keeps a columnar copy of each shard's fixed-width task fields, which
+    // filter scans and dashboard counts then read instead of whole tasks
+    void setColumnarStorage(bool enabled) {
+        auto locks = lockAllShards();
+        for (auto& shard : shards) {
+            shard.tasks.enableColumns(enabled);
+        }
+    }
+
+    // Journal records tolerated before a compaction is considered; compaction
+    // also waits until the journal is as large as the task set itself.
+    void setMinCompactionRecords(size_t records) {
+        minCompactionRecords = records;
+    }
+
+    // Checkpoints a journal with records at least this often, bounding the
+    // replay after a crash by time as well as size; zero disables
+    void setCheckpointInterval(std::chrono::seconds interval) {
+        std::lock_guard<std::mutex> lock(compactionMutex);
+        checkpointInterval = static_cast<uint32_t>(interval.count());
+        compactionCv.notify_one();
+    }
+
+    // PBKDF2 iterations for passwords hashed from now on, including legacy
+    // plaintext ones upgraded on first login; existing hashes keep their own
+    // cost
+    void setPasswordHashIterations(uint32_t iterations) {
+        users.setHashIterations(iterations);
+    }
+
+    // How long a successful login lets the same credentials skip password
+    // hashing; zero disables the cache
+    void setCredentialCacheTtl(std::chrono::seconds ttl) {
+        users.setCacheTtl(ttl);
     }
 
     // User management
+    // The password is hashed before any lock is taken; the new user is in
+    // the users journal on disk by the time this returns
     bool addUser(const std::string& username, const std::string& password) {
-        std::lock_guard<std::mutex> lock(userMutex);
-        for (const auto& user : users) {
-            if (user.getUsername() == username) {
-                return false; // User already exists
+        if (users.contains(username)) {
+            return false; // User already exists
+        }
+        User user = users.create(username, password);
+        std::string record = user.serialize();
+        uint64_t sequence;
+        {
+            auto lock = acquire<std::unique_lock<std::mutex>>(userMutex, LockSite::USERS);
+            if (!users.insert(std::move(user))) {
+                return false; // Registered meanwhile
+            }
+            sequence = userJournal.append('A', record);
+            uncommittedUsers.emplace(username, sequence);
+        }
+        bool committed = userJournal.waitForCommit(sequence);
+        {
+            auto lock = acquire<std::unique_lock<std::mutex>>(userMutex, LockSite::USERS);
+            uncommittedUsers.erase(username);
+            if (!committed) {
+                // Not durable, so the account must not outlive this process either
+                users.remove(username);
             }
         }
-        users.emplace_back(username, password);
-        saveUsers();
+        if (!committed) {
+            std::cerr << "Failed to record new user " << username << std::endl;
+            return false;
+        }
+        UserNames::instance().intern(username);
+        recordUserMutation();
         return true;
     }
 
     int login(const std::string& username, const std::string& password) {
-        std::lock_guard<std::mutex> userLock(userMutex);
-        for (const auto& user : users) {
-            if (user.getUsername() == username && user.authenticate(password)) {
-                std::lock_guard<std::mutex> sessionLock(sessionMutex);
-                int sessionId = nextSessionId++;
-                activeSessions.emplace(sessionId, Session(sessionId, username));
-                return sessionId;
+        OperationTimer timer(Operation::LOGIN);
+        std::string upgradedRecord;
+        if (!users.authenticate(username, password, &upgradedRecord)) {
+            return -1; // Login failed
+        }
+        if (!upgradedRecord.empty()) {
+            // Not waited for: if it is lost, the plaintext record stays and
+            // the next login upgrades it again
+            {
+                auto lock = acquire<std::unique_lock<std::mutex>>(userMutex, LockSite::USERS);
+                userJournal.append('U', upgradedRecord);
             }
+            recordUserMutation();
         }
-        return -1; // Login failed
+        UserId userId = UserNames::instance().intern(username);
+        auto lock = acquire<std::unique_lock<std::mutex>>(sessionMutex, LockSite::SESSIONS);
+        int sessionId = nextSessionId++;
+        uint32_t now = sessionClock.load(std::memory_order_relaxed);
+        sessionTable.insert(sessionId, userId, now);
+        Session& session = activeSessions.emplace(sessionId, Session(sessionId, userId, now)).first->second;
+        armSessionTimer(session);
+        return sessionId;
     }
 
     bool logout(int sessionId) {
-        std::lock_guard<std::mutex> lock(sessionMutex);
+        OperationTimer timer(Operation::LOGOUT);
+        auto lock = acquire<std::unique_lock<std::mutex>>(sessionMutex, LockSite::SESSIONS);
         auto it = activeSessions.find(sessionId);
         if (it != activeSessions.end()) {
+            sessionTimers.cancel(it->second.getExpiryTimer());
+            sessionTable.erase(sessionId);
             activeSessions.erase(it);
             return true;
         }
         return false;
     }
 
-    std::string getUsernameFromSession(int sessionId) {
-        std::lock_guard<std::mutex> lock(sessionMutex);
-        auto it = activeSessions.find(sessionId);
-        if (it != activeSessions.end()) {
-            return it->second.getUsername();
-        }
-        return "";
+    // Wait-free, and counts as a use of the session; returns NO_USER for an
+    // unknown or expired session
+    UserId getUserFromSession(int sessionId) const {
+        return sessionTable.touch(sessionId, sessionClock.load(std::memory_order_relaxed));
+    }
+
+    std::string getUsernameFromSession(int sessionId) const {
+        UserId userId = getUserFromSession(sessionId);
+        return userId != NO_USER ? UserNames::instance().name(userId) : "";
     }
 
     // Task management
     int addTask(const std::string& title, const std::string& category, 
                const std::string& assignedTo, Priority priority, bool isShared, int sessionId) {
-        std::string username = getUsernameFromSession(sessionId);
-        if (username.empty()) {
+        OperationTimer timer(Operation::ADD_TASK);
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
             return -1; // Invalid session
         }
 
-        std::lock_guard<std::mutex> lock(taskMutex);
+        UserId assignee = UserNames::instance().intern(assignedTo);
+        Durability mode = durability;
         int taskId = nextTaskId++;
-        tasks.emplace_back(taskId, title, category, assignedTo, priority, isShared);
-        saveTasks();
+        uint64_t sequence;
+        {
+            TaskShard& shard = shardFor(taskId);
+            auto lock = acquire<std::unique_lock<std::shared_mutex>>(shard.mutex, LockSite::SHARD_WRITE);
+            const StoredTask& task = shard.tasks.upsert(Task(taskId, title, category, assignee, priority, isShared));
+            shard.index.add(task);
+            ++taskCount;
+            sequence = journal.appendAdd(task);
+            if (mode == Durability::SYNC) {
+                recordUndo(sequence, {UndoStep{taskId, std::nullopt}});
+            }
+            changes.publish(ChangeEvent(ChangeType::ADDED, task.toTask(), NO_USER, false));
+        }
+        recordMutation();
+        if (!awaitDurability(sequence, mode)) {
+            return -1; // Not durable, and undone
+        }
         return taskId;
     }
 
     bool updateTask(int taskId, const std::string& title, const std::string& category, 
                    const std::string& assignedTo, bool completed, Priority priority, 
                    bool isShared, int sessionId) {
-        std::string username = getUsernameFromSession(sessionId);
-        if (username.empty()) {
+        OperationTimer timer(Operation::UPDATE_TASK);
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
             return false; // Invalid session
         }
 
-        std::lock_guard<std::mutex> lock(taskMutex);
-        for (auto& task : tasks) {
-            if (task.getId() == taskId) {
-                // Check if user has permission to update this task
-                if (task.getAssignedTo() == username || task.getIsShared()) {
-                    task.setTitle(title);
-                    task.setCategory(category);
-                    task.setAssignedTo(assignedTo);
-                    task.setCompleted(completed);
-                    task.setPriority(priority);
-                    task.setShared(isShared);
-                    saveTasks();
-                    return true;
+        UserId assignee = UserNames::instance().intern(assignedTo);
+        CategoryId categoryId = CategoryNames::instance().intern(category);
+        Durability mode = durability;
+        uint64_t sequence = 0;
+        {
+            TaskShard& shard = shardFor(taskId);
+            auto lock = acquire<std::unique_lock<std::shared_mutex>>(shard.mutex, LockSite::SHARD_WRITE);
+            StoredTask* task = shard.tasks.find(taskId);
+            // Check if user has permission to update this task
+            if (task && (task->getAssigneeId() == userId || task->getIsShared())) {
+                UserId previousAssignee = task->getAssigneeId();
+                bool previousShared = task->getIsShared();
+                std::optional<Task> before;
+                if (mode == Durability::SYNC) {
+                    before = task->toTask();
+                }
+                shard.index.remove(*task);
+                shard.tasks.setTitle(*task, title);
+                task->setCategoryId(categoryId);
+                task->setAssigneeId(assignee);
+                task->setCompleted(completed);
+                task->setPriority(priority);
+                task->setShared(isShared);
+                shard.tasks.refresh(taskId);
+                shard.index.add(*task);
+                sequence = journal.appendUpdate(*task);
+                if (mode == Durability::SYNC) {
+                    recordUndo(sequence, {UndoStep{taskId, std::move(before)}});
+                }
+                changes.publish(ChangeEvent(ChangeType::UPDATED, task->toTask(), previousAssignee, previousShared));
+            }
+        }
+        if (sequence == 0) {
+            return false; // Task not found or no permission
+        }
+        recordMutation();
+        return awaitDurability(sequence, mode);
+    }
+
+    // Changes only the fields set in patch. The index entries of untouched
+    // fields stay as they are and the journal records just the new values,
+    // so the common edits (completing, reprioritizing) stay cheap.
+    bool patchTask(int taskId, const TaskPatch& patch, int sessionId) {
+        OperationTimer timer(Operation::PATCH_TASK);
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
+            return false; // Invalid session
+        }
+
+        UserId assignee = patch.has(TaskField::ASSIGNEE) ? UserNames::instance().intern(patch.getAssignedTo()) : NO_USER;
+        CategoryId categoryId = patch.has(TaskField::CATEGORY) ? CategoryNames::instance().intern(patch.getCategory()) : NOT_INTERNED;
+        Durability mode = durability;
+        bool permitted = false;
+        uint64_t sequence = 0;
+        {
+            TaskShard& shard = shardFor(taskId);
+            auto lock = acquire<std::unique_lock<std::shared_mutex>>(shard.mutex, LockSite::SHARD_WRITE);
+            StoredTask* task = shard.tasks.find(taskId);
+            // Check if user has permission to update this task
+            permitted = task && (task->getAssigneeId() == userId || task->getIsShared());
+            if (permitted && !patch.empty()) {
+                UserId previousAssignee = task->getAssigneeId();
+                bool previousShared = task->getIsShared();
+                std::optional<Task> before;
+                if (mode == Durability::SYNC) {
+                    before = task->toTask();
+                }
+                bool textChanged = patch.has(TaskField::TITLE) || patch.has(TaskField::CATEGORY);
+                if (textChanged) {
+                    shard.index.removeText(*task);
+                }
+                if (patch.has(TaskField::ASSIGNEE)) {
+                    shard.index.reassign(taskId, previousAssignee, assignee);
+                }
+                if (patch.has(TaskField::CATEGORY)) {
+                    shard.index.recategorize(taskId, task->getCategoryId(), categoryId);
+                }
+                if (patch.has(TaskField::SHARED)) {
+                    shard.index.setShared(taskId, patch.getIsShared());
+                }
+                if (patch.has(TaskField::COMPLETED)) {
+                    shard.index.setCompleted(taskId, patch.isCompleted());
+                }
+                writePatch(shard.tasks, *task, patch, assignee, categoryId);
+                if (textChanged) {
+                    shard.index.addText(*task);
+                }
+                sequence = journal.appendPatch(taskId, patch);
+                if (mode == Durability::SYNC) {
+                    recordUndo(sequence, {UndoStep{taskId, std::move(before)}});
                 }
-                return false; // No permission
+                changes.publish(ChangeEvent(ChangeType::UPDATED, task->toTask(), previousAssignee, previousShared));
             }
         }
-        return false; // Task not found
+        if (!permitted) {
+            return false; // Task not found or no permission
+        }
+        if (sequence != 0) {
+            recordMutation();
+            return awaitDurability(sequence, mode);
+        }
+        return true;
     }
 
     bool deleteTask(int taskId, int sessionId) {
-        std::string username = getUsernameFromSession(sessionId);
-        if (username.empty()) {
+        OperationTimer timer(Operation::DELETE_TASK);
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
             return false; // Invalid session
         }
 
-        std::lock_guard<std::mutex> lock(taskMutex);
-        for (auto it = tasks.begin(); it != tasks.end(); ++it) {
-            if (it->getId() == taskId) {
-                // Check if user has permission to delete this task
-                if (it->getAssignedTo() == username || it->getIsShared()) {
-                    tasks.erase(it);
-                    saveTasks();
-                    return true;
+        Durability mode = durability;
+        uint64_t sequence = 0;
+        {
+            TaskShard& shard = shardFor(taskId);
+            auto lock = acquire<std::unique_lock<std::shared_mutex>>(shard.mutex, LockSite::SHARD_WRITE);
+            const StoredTask* task = shard.tasks.find(taskId);
+            // Check if user has permission to delete this task
+            if (task && (task->getAssigneeId() == userId || task->getIsShared())) {
+                ChangeEvent event(ChangeType::DELETED, Task(taskId, "", "", NO_USER, Priority::LOW, false),
+                                  task->getAssigneeId(), task->getIsShared());
+                std::optional<Task> before;
+                if (mode == Durability::SYNC) {
+                    before = task->toTask();
+                }
+                shard.index.remove(*task);
+                shard.tasks.erase(taskId);
+                --taskCount;
+                sequence = journal.appendDelete(taskId);
+                if (mode == Durability::SYNC) {
+                    recordUndo(sequence, {UndoStep{taskId, std::move(before)}});
                 }
-                return false; // No permission
+                changes.publish(std::move(event));
             }
         }
-        return false; // Task not found
+        if (sequence == 0) {
+            return false; // Task not found or no permission
+        }
+        recordMutation();
+        return awaitDurability(sequence, mode);
     }
 
-    std::vector<Task> getPersonalTasks(int sessionId) {
-        std::vector<Task> result;
-        std::string username = getUsernameFromSession(sessionId);
-        if (username.empty()) {
-            return result; // Invalid session
+    // Applies every operation of the batch in order, or none of them: the
+    // session is checked once, every shard is locked once, and all updates
+    // and deletes are checked for existence and permission before anything
+    // changes. The batch goes to the journal as one unit and is waited on
+    // once, and if it fails to commit the whole batch is undone again. Ids
+    // of added tasks are appended to addedIds in batch order.
+    bool applyBatch(const TaskBatch& batch, int sessionId, std::vector<int>* addedIds = nullptr) {
+        OperationTimer timer(Operation::APPLY_BATCH);
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
+            return false; // Invalid session
+        }
+        if (batch.empty()) {
+            return true;
+        }
+
+        const std::vector<BatchOp>& ops = batch.getOps();
+        std::vector<UserId> assignees(ops.size(), NO_USER);
+        std::vector<CategoryId> categoryIds(ops.size(), NOT_INTERNED);
+        for (size_t i = 0; i < ops.size(); ++i) {
+            if (ops[i].type != BatchOpType::DELETE) {
+                assignees[i] = UserNames::instance().intern(ops[i].assignedTo);
+                categoryIds[i] = CategoryNames::instance().intern(ops[i].category);
+            }
+        }
+
+        // Owner and sharing of each touched task as of the operation being
+        // checked, so that e.g. a reassignment revokes the rights it hands away
+        struct Access {
+            bool exists;
+            UserId assignee;
+            bool isShared;
+        };
+
+        Durability mode = durability;
+        uint64_t sequence;
+        {
+            auto locks = lockAllShards();
+            std::unordered_map<int, Access> touched;
+            for (size_t i = 0; i < ops.size(); ++i) {
+                const BatchOp& op = ops[i];
+                if (op.type == BatchOpType::ADD) {
+                    continue;
+                }
+                auto it = touched.find(op.taskId);
+                if (it == touched.end()) {
+                    const StoredTask* task = shardFor(op.taskId).tasks.find(op.taskId);
+                    Access access = task ? Access{true, task->getAssigneeId(), task->getIsShared()}
+                                         : Access{false, NO_USER, false};
+                    it = touched.emplace(op.taskId, access).first;
+                }
+                Access& access = it->second;
+                if (!access.exists || (access.assignee != userId && !access.isShared)) {
+                    return false; // Task not found or no permission
+                }
+                if (op.type == BatchOpType::DELETE) {
+                    access.exists = false;
+                } else {
+                    access.assignee = assignees[i];
+                    access.isShared = op.isShared;
+                }
+            }
+
+            int nextId = nextTaskId.fetch_add(static_cast<int>(batch.getAddCount()));
+            TaskJournal::Batch records;
+            std::vector<UndoStep> undoSteps;
+            for (size_t i = 0; i < ops.size(); ++i) {
+                const BatchOp& op = ops[i];
+                if (op.type == BatchOpType::ADD) {
+                    int taskId = nextId++;
+                    TaskShard& shard = shardFor(taskId);
+                    const StoredTask& task = shard.tasks.upsert(
+                        Task(taskId, op.title, op.category, assignees[i], op.priority, op.isShared));
+                    shard.index.add(task);
+                    records.add(task);
+                    if (mode == Durability::SYNC) {
+                        undoSteps.push_back(UndoStep{taskId, std::nullopt});
+                    }
+                    changes.publish(ChangeEvent(ChangeType::ADDED, task.toTask(), NO_USER, false));
+                    ++taskCount;
+                    if (addedIds) {
+                        addedIds->push_back(taskId);
+                    }
+                } else if (op.type == BatchOpType::UPDATE) {
+                    TaskShard& shard = shardFor(op.taskId);
+                    StoredTask* task = shard.tasks.find(op.taskId);
+                    UserId previousAssignee = task->getAssigneeId();
+                    bool previousShared = task->getIsShared();
+                    if (mode == Durability::SYNC) {
+                        undoSteps.push_back(UndoStep{op.taskId, task->toTask()});
+                    }
+                    shard.index.remove(*task);
+                    shard.tasks.setTitle(*task, op.title);
+                    task->setCategoryId(categoryIds[i]);
+                    task->setAssigneeId(assignees[i]);
+                    task->setCompleted(op.completed);
+                    task->setPriority(op.priority);
+                    task->setShared(op.isShared);
+                    shard.tasks.refresh(op.taskId);
+                    shard.index.add(*task);
+                    records.update(*task);
+                    changes.publish(ChangeEvent(ChangeType::UPDATED, task->toTask(), previousAssignee, previousShared));
+                } else {
+                    TaskShard& shard = shardFor(op.taskId);
+                    const StoredTask* task = shard.tasks.find(op.taskId);
+                    ChangeEvent event(ChangeType::DELETED, Task(op.taskId, "", "", NO_USER, Priority::LOW, false),
+                                      task->getAssigneeId(), task->getIsShared());
+                    if (mode == Durability::SYNC) {
+                        undoSteps.push_back(UndoStep{op.taskId, task->toTask()});
+                    }
+                    shard.index.remove(*task);
+                    shard.tasks.erase(op.taskId);
+                    records.remove(op.taskId);
+                    changes.publish(std::move(event));
+                    --taskCount;
+                }
+            }
+            sequence = journal.appendBatch(records);
+            if (mode == Durability::SYNC) {
+                recordUndo(sequence, std::move(undoSteps));
+            }
+        }
+        recordMutation();
+        return awaitDurability(sequence, mode);
+    }
+
+    // Calls visit(const StoredTask&) on up to limit tasks of the view whose ids
+    // follow afterId, in id order. Every shard stays locked shared for the
+    // whole page, so the page is a consistent snapshot and nothing is
+    // copied; the reference is only valid during the call. Returns the
+    // cursor to pass as afterId for the next page, 0 once the view is
+    // exhausted, or -1 for an invalid session or a zero limit, which could
+    // never make progress.
+    template <typename Visitor>
+    int visitTasks(int sessionId, TaskView view, int afterId, size_t limit, Visitor visit) {
+        OperationTimer timer(Operation::LIST_TASKS);
+        if (limit == 0) {
+            return -1;
+        }
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
+            return -1; // Invalid session
         }
 
-        std::lock_guard<std::mutex> lock(taskMutex);
-        for (const auto& task : tasks) {
-            if (task.getAssignedTo() == username && !task.getIsShared()) {
-                result.push_back(task);
+        auto locks = lockAllShardsShared();
+        // Merge the shards' ordered id sets, starting after the cursor
+        typedef std::set<int>::const_iterator Position;
+        std::array<std::pair<Position, Position>, TASK_SHARD_COUNT> ranges;
+        for (int s = 0; s < TASK_SHARD_COUNT; ++s) {
+            const std::set<int>& ids = view == TaskView::SHARED ? shards[s].index.sharedTasks()
+                                                                : shards[s].index.assignedTo(userId);
+            ranges[s] = std::make_pair(ids.upper_bound(afterId), ids.end());
+        }
+
+        int cursor = afterId;
+        size_t visited = 0;
+        while (true) {
+            int next = -1;
+            for (int s = 0; s < TASK_SHARD_COUNT; ++s) {
+                if (ranges[s].first != ranges[s].second &&
+                    (next < 0 || *ranges[s].first < *ranges[next].first)) {
+                    next = s;
+                }
+            }
+            if (next < 0) {
+                return 0;
             }
+            // Filter before checking the limit, so a full page whose
+            // remaining ids are all filtered out still ends the listing
+            int taskId = *ranges[next].first;
+            const StoredTask* task = shards[next].tasks.find(taskId);
+            if (view == TaskView::PERSONAL && task->getIsShared()) {
+                ++ranges[next].first;
+                continue;
+            }
+            if (visited == limit) {
+                return cursor;
+            }
+            ++ranges[next].first;
+            visit(*task);
+            ++visited;
+            cursor = taskId;
         }
+    }
+
+    std::vector<Task> getPersonalTasks(int sessionId) {
+        std::vector<Task> result;
+        visitTasks(sessionId, TaskView::PERSONAL, 0, SIZE_MAX, [&result](const StoredTask& task) {
+            result.push_back(task.toTask());
+        });
         return result;
     }
 
     std::vector<Task> getSharedTasks(int sessionId) {
         std::vector<Task> result;
-        std::string username = getUsernameFromSession(sessionId);
-        if (username.empty()) {
+        visitTasks(sessionId, TaskView::SHARED, 0, SIZE_MAX, [&result](const StoredTask& task) {
+            result.push_back(task.toTask());
+        });
+        return result;
+    }
+
+    // Runs a query over the tasks the session's user can see, in one
+    // consistent snapshot. Matches are gathered as pointers; with a limit only
+    // the best limit of them are kept, in a bounded heap, so the top k of a
+    // large result never sorts the rest.
+    std::vector<Task> queryTasks(int sessionId, const TaskQuery& query) {
+        OperationTimer timer(Operation::QUERY_TASKS);
+        std::vector<Task> result;
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER || query.limit == 0) {
             return result; // Invalid session
         }
+        UserId assignee = NO_USER;
+        if (query.assignedTo) {
+            assignee = UserNames::instance().find(*query.assignedTo);
+            if (assignee == NO_USER) {
+                return result; // Never assigned anything
+            }
+        }
+        CategoryId categoryId = NOT_INTERNED;
+        if (query.category) {
+            categoryId = CategoryNames::instance().find(*query.category);
+            if (categoryId == NOT_INTERNED) {
+                return result; // No task ever had this category
+            }
+        }
 
-        std::lock_guard<std::mutex> lock(taskMutex);
-        for (const auto& task : tasks) {
-            if (task.getIsShared()) {
-                result.push_back(task);
+        auto order = [&query](const StoredTask* a, const StoredTask* b) {
+            return query.sortsBefore(*a, *b);
+        };
+        std::vector<const StoredTask*> best; // Max-heap by order once full
+        auto locks = lockAllShardsShared();
+        for (const auto& shard : shards) {
+            forEachCandidate(shard, query, assignee, [&](const StoredTask& task) {
+                if ((!task.getIsShared() && task.getAssigneeId() != userId) ||
+                    !query.matches(task, assignee, categoryId)) {
+                    return;
+                }
+                if (best.size() < query.limit) {
+                    best.push_back(&task);
+                    if (best.size() == query.limit) {
+                        std::make_heap(best.begin(), best.end(), order);
+                    }
+                } else if (order(&task, best.front())) {
+                    std::pop_heap(best.begin(), best.end(), order);
+                    best.back() = &task;
+                    std::push_heap(best.begin(), best.end(), order);
+                }
+            });
+        }
+        std::sort(best.begin(), best.end(), order);
+        result.reserve(best.size());
+        for (const StoredTask* task : best) {
+            result.push_back(task->toTask());
+        }
+        return result;
+    }
+
+    // Visible pending tasks per priority, for dashboards. Reads only the
+    // packed flag and priority columns when they are enabled.
+    std::array<size_t, 3> getPendingByPriority(int sessionId) {
+        OperationTimer timer(Operation::PENDING_BY_PRIORITY);
+        std::array<size_t, 3> counts = {0, 0, 0};
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
+            return counts; // Invalid session
+        }
+
+        auto locks = lockAllShardsShared();
+        for (const auto& shard : shards) {
+            if (const TaskColumns* columns = shard.tasks.getColumns()) {
+                std::vector<uint64_t> mask = columns->allRows();
+                columns->whereCompleted(false, mask);
+                columns->whereVisibleTo(userId, mask);
+                columns->countByPriority(mask, counts);
+            } else {
+                shard.index.forEachPending([&](int taskId) {
+                    const StoredTask* task = shard.tasks.find(taskId);
+                    if (task->getIsShared() || task->getAssigneeId() == userId) {
+                        ++counts[static_cast<size_t>(task->getPriority())];
+                    }
+                });
             }
         }
+        return counts;
+    }
+
+    // Full-text search over titles and categories, e.g. "groc* list". Returns
+    // up to limit visible matches in id order.
+    std::vector<Task> searchTasks(int sessionId, const std::string& text, size_t limit) {
+        OperationTimer timer(Operation::SEARCH_TASKS);
+        std::vector<Task> result;
+        UserId userId = getUserFromSession(sessionId);
+        TextQuery query = TextIndex::parseQuery(text);
+        if (userId == NO_USER || query.empty() || limit == 0) {
+            return result;
+        }
+
+        std::vector<const StoredTask*> matches;
+        auto locks = lockAllShardsShared();
+        for (const auto& shard : shards) {
+            // Each shard yields ids in order, so its first limit matches suffice
+            size_t found = 0;
+            shard.index.textIndex().search(query, [&shard](int taskId) {
+                return shard.tasks.find(taskId);
+            }, [&](const StoredTask& task) {
+                if (!task.getIsShared() && task.getAssigneeId() != userId) {
+                    return true;
+                }
+                matches.push_back(&task);
+                return ++found < limit;
+            });
+        }
+        std::sort(matches.begin(), matches.end(), [](const StoredTask* a, const StoredTask* b) {
+            return a->getId() < b->getId();
+        });
+        if (matches.size() > limit) {
+            matches.resize(limit);
+        }
+        result.reserve(matches.size());
+        for (const StoredTask* task : matches) {
+            result.push_back(task->toTask());
+        }
         return result;
     }
 
-    Task* getTaskById(int taskId, int sessionId) {
-        std::string username = getUsernameFromSession(sessionId);
-        if (username.empty()) {
+    // Returns a copy: stored tasks move around as others are deleted
+    std::unique_ptr<Task> getTaskById(int taskId, int sessionId) {
+        OperationTimer timer(Operation::GET_TASK);
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
             return nullptr; // Invalid session
         }
 
-        std::lock_guard<std::mutex> lock(taskMutex);
-        for (auto& task : tasks) {
-            if (task.getId() == taskId) {
-                // Check if user has permission to view this task
-                if (task.getAssignedTo() == username || task.getIsShared()) {
-                    return &task;
-                }
-            }
+        TaskShard& shard = shardFor(taskId);
+        auto lock = acquire<std::shared_lock<std::shared_mutex>>(shard.mutex, LockSite::SHARD_READ);
+        const StoredTask* task = shard.tasks.find(taskId);
+        // Check if user has permission to view this task
+        if (task && (task->getAssigneeId() == userId || task->getIsShared())) {
+            return std::unique_ptr<Task>(new Task(task->toTask()));
         }
         return nullptr; // Task not found or no permission
     }
 
-    // File I/O
-    void loadTasks() {
-        std::lock_guard<std::mutex> lock(taskMutex);
-        tasks.clear();
-        std::ifstream file(tasksFilePath);
-        if (!file.is_open()) {
-            return; // File doesn't exist yet
+    // Change feed
+    // To follow changes, a client takes the current version, lists its
+    // tasks, then polls getChanges from that version. Events it already saw
+    // in the listing are safe to apply again.
+    uint64_t getChangeVersion() const {
+        return changes.currentVersion();
+    }
+
+    // Appends up to maxEvents changes after since that the session's user
+    // can see and sets resumeFrom to the version to poll from next. A change
+    // that hides a task from the user arrives as DELETED. On RESYNC the
+    // client must list its tasks again and resume from resumeFrom.
+    ChangeStatus getChanges(int sessionId, uint64_t since, size_t maxEvents,
+                            std::vector<ChangeEvent>& out, uint64_t& resumeFrom) {
+        OperationTimer timer(Operation::GET_CHANGES);
+        UserId userId = getUserFromSession(sessionId);
+        if (userId == NO_USER) {
+            return ChangeStatus::INVALID_SESSION;
+        }
+
+        resumeFrom = changes.currentVersion();
+        std::vector<ChangeEvent> events;
+        if (changes.read(since, maxEvents, events) == ChangeStatus::RESYNC) {
+            return ChangeStatus::RESYNC;
+        }
+        resumeFrom = events.empty() ? since : events.back().version;
+        for (auto& event : events) {
+            bool visibleBefore = event.type != ChangeType::ADDED &&
+                (event.previousShared || event.previousAssignee == userId);
+            bool visibleAfter = event.type != ChangeType::DELETED &&
+                (event.task.getIsShared() || event.task.getAssigneeId() == userId);
+            if (visibleAfter) {
+                out.push_back(std::move(event));
+            } else if (visibleBefore) {
+                ChangeEvent removed(ChangeType::DELETED,
+                                    Task(event.task.getId(), "", "", NO_USER, Priority::LOW, false),
+                                    event.previousAssignee, event.previousShared);
+                removed.version = event.version;
+                out.push_back(std::move(removed));
+            }
+        }
+        return ChangeStatus::OK;
+    }
+
+    // Long poll: waits until a change newer than since exists
+    bool waitForChanges(uint64_t since, std::chrono::milliseconds timeout) const {
+        return changes.waitFor(since, timeout);
+    }
+
+    // Statistics
+    // Writes current gauges and, in builds with TASKMANAGER_METRICS, the
+    // operation latency and lock contention figures, one line each:
+    //   gauge|<name>|<value>, op|<name>|key=value..., lock|<name>|key=value...
+    void dumpStats(std::ostream& out) {
+        size_t sessions;
+        {
+            auto lock = acquire<std::unique_lock<std::mutex>>(sessionMutex, LockSite::SESSIONS);
+            sessions = activeSessions.size();
         }
+        out << "gauge|tasks|" << taskCount << '\n'
+            << "gauge|sessions|" << sessions << '\n'
+            << "gauge|users|" << users.size() << '\n'
+            << "gauge|sessions_expired|" << expiredSessions << '\n'
+            << "gauge|journal_records|" << journal.getRecordCount() << '\n'
+            << "gauge|checkpoints_disabled|" << (checkpointsDisabled ? 1 : 0) << '\n'
+            << "gauge|user_journal_records|" << userJournal.getRecordCount() << '\n'
+            << "gauge|change_version|" << changes.currentVersion() << '\n';
+#ifdef TASKMANAGER_METRICS
+        Metrics::instance().dump(out);
+#endif
+    }
 
-        std::string line;
-        while (std::getline(file, line)) {
+    // File I/O
+    // Loads the tasks snapshot, then replays any journal left by an
+    // interrupted compaction followed by the live journal tail. Snapshot
+    // parsing, shard filling and index building run on a thread pool.
+    void loadTasks() {
+        OperationTimer timer(Operation::LOAD_TASKS);
+        auto locks = lockAllShards();
+        ThreadPool pool;
+        std::vector<TaskChunk> chunks;
+        std::ifstream probe(tasksFilePath);
+        if (probe.is_open()) {
+            probe.close();
             try {
-                Task task = Task::deserialize(line);
-                tasks.push_back(task);
-                if (task.getId() >= nextTaskId) {
-                    nextTaskId = task.getId() + 1;
+                if (isBinarySnapshot(tasksFilePath)) {
+                    snapshotFormat = SnapshotFormat::BINARY;
+                    MappedSnapshot snapshot;
+                    snapshot.open(tasksFilePath);
+                    chunks = parseTaskSnapshotParallel(snapshot, pool);
+                } else {
+                    MappedFile file;
+                    file.open(tasksFilePath);
+                    file.adviseSequential();
+                    chunks = parseTaskTextParallel(file, pool);
                 }
             } catch (const std::exception& e) {
-                std::cerr << "Error loading task: " << e.what() << std::endl;
+                std::cerr << "Error loading tasks snapshot: " << e.what() << std::endl;
+                chunks.clear();
+                quarantineSnapshot();
             }
         }
-        file.close();
-    }
+        std::ifstream quarantined(getQuarantinePath());
+        if (quarantined.is_open()) {
+            checkpointsDisabled = true;
+            std::cerr << "Checkpoints disabled until " << getQuarantinePath()
+                      << " is repaired or removed" << std::endl;
+        }
 
-    void saveTasks() {
-        std::ofstream file(tasksFilePath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open tasks file for writing" << std::endl;
-            return;
+        // Each chunk already knows its largest id; combine those
+        int maxId = 0;
+        size_t lineOffset = 0;
+        for (const auto& chunk : chunks) {
+            maxId = std::max(maxId, chunk.maxId);
+            for (const auto& error : chunk.errors) {
+                std::cerr << "Error loading task at " << tasksFilePath << ":"
+                          << lineOffset + error.first << ": " << error.second << std::endl;
+            }
+            lineOffset += chunk.lines;
         }
+        raiseNextTaskId(maxId);
 
-        for (const auto& task : tasks) {
-            file << task.serialize() << std::endl;
+        std::vector<std::future<void>> pending;
+        for (int s = 0; s < TASK_SHARD_COUNT; ++s) {
+            pending.push_back(pool.submit([this, &chunks, s] {
+                TaskStore& store = shards[s].tasks;
+                store.clear();
+                size_t total = 0;
+                for (const auto& chunk : chunks) {
+                    total += chunk.byShard[s].size();
+                }
+                store.reserve(total);
+                for (auto& chunk : chunks) {
+                    for (auto& task : chunk.byShard[s]) {
+                        store.upsert(task);
+                    }
+                }
+            }));
         }
-        file.close();
-    }
+        for (auto& job : pending) {
+            job.get();
+        }
+        chunks.clear();
 
-    void loadUsers() {
-        std::lock_guard<std::mutex> lock(userMutex);
-        users.clear();
-        std::ifstream file(usersFilePath);
-        if (!file.is_open()) {
-            // Add a default admin user if the file doesn't exist
-            users.emplace_back("admin", "admin");
-            return;
+        auto apply = [this](char op, std::string_view payload) {
+            applyJournalRecord(op, payload);
+        };
+        size_t rotatedRecords = TaskJournal::replay(journal.getRotatedPath(), apply);
+        size_t liveRecords = TaskJournal::replay(journal.getPath(), apply);
+        journal.setRecordCount(rotatedRecords + liveRecords);
+
+        // Indexes are built once the final state is known rather than
+        // maintained through every replayed record
+        pending.clear();
+        for (auto& shard : shards) {
+            pending.push_back(pool.submit([&shard] {
+                shard.index.clear();
+                for (const auto& task : shard.tasks) {
+                    shard.index.add(task);
+                }
+            }));
+        }
+        taskCount = 0;
+        for (size_t s = 0; s < pending.size(); ++s) {
+            pending[s].get();
+            taskCount += shards[s].tasks.size();
         }
 
-        std::string line;
-        while (std::getline(file, line)) {
-            try {
-                User user = User::deserialize(line);
-                users.push_back(user);
-            } catch (const std::exception& e) {
-                std::cerr << "Error loading user: " << e.what() << std::endl;
+        // A leftover rotated log means compaction was cut short; fold both
+        // logs into the snapshot now so the next rotation starts clean.
+        std::ifstream rotated(journal.getRotatedPath());
+        if (rotated.is_open() && !checkpointsDisabled) {
+            rotated.close();
+            if (writeTasksSnapshot(captureTasks())) {
+                journal.reset();
+                journal.discardRotated();
             }
         }
-        file.close();
     }
 
-    void saveUsers() {
-        std::ofstream file(usersFilePath);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open users file for writing" << std::endl;
-            return;
+    // Where an unreadable tasks snapshot is moved
+    std::string getQuarantinePath() const {
+        return tasksFilePath + ".corrupt";
+    }
+
+    // Moves an unreadable tasks snapshot aside, unless an earlier one is
+    // already there, in which case it stays where it is
+    void quarantineSnapshot() {
+        std::ifstream existing(getQuarantinePath());
+        if (existing.is_open() || std::rename(tasksFilePath.c_str(), getQuarantinePath().c_str()) != 0) {
+            std::cerr << "Leaving unreadable tasks snapshot at " << tasksFilePath << std::endl;
         }
+    }
 
-        for (const auto& user : users) {
-            file << user.serialize() << std::endl;
+    // Writes a full snapshot now and retires the journal it supersedes.
+    // Requests are held off only while the task records are copied.
+    void saveTasks() {
+        OperationTimer timer(Operation::SAVE_TASKS);
+        std::lock_guard<std::mutex> checkpointLock(checkpointMutex);
+        checkpoint();
+    }
+
+    // Loads the users file, then replays the users journal over it.
+    // Plaintext passwords from older users files are loaded as they are;
+    // each is hashed on that user's first successful login and journaled
+    // as an upgrade ('U'), so it leaves disk at the next compaction.
+    void loadUsers() {
+        OperationTimer timer(Operation::LOAD_USERS);
+        bool rewrite;
+        {
+            auto lock = acquire<std::unique_lock<std::mutex>>(userMutex, LockSite::USERS);
+            users.clear();
+            std::ifstream file(usersFilePath);
+            rewrite = !file.is_open();
+            if (rewrite) {
+                // Add a default admin user if the file doesn't exist
+                users.add("admin", "admin");
+                UserNames::instance().intern("admin");
+            } else {
+                file.close();
+                parseUserFile(usersFilePath, [this](User&& user) {
+                    UserNames::instance().intern(user.getUsername());
+                    users.insert(std::move(user));
+                }, [this](size_t lineNumber, const char* message) {
+                    std::cerr << "Error loading user at " << usersFilePath << ":" << lineNumber
+                              << ": " << message << std::endl;
+                });
+            }
+
+            // A record may repeat one already in the file if a compaction
+            // was cut short; the first copy of an add wins and an upgrade
+            // ('U') rewrites the same hash, so replay is harmless
+            size_t replayed = TaskJournal::replay(userJournal.getPath(), [this](char op, std::string_view payload) {
+                if (op != 'A' && op != 'U') {
+                    throw std::runtime_error("Unknown user journal record type");
+                }
+                User user = User::parse(payload);
+                UserNames::instance().intern(user.getUsername());
+                if (op == 'U') {
+                    users.replace(std::move(user));
+                } else {
+                    users.insert(std::move(user));
+                }
+            });
+            userJournal.setRecordCount(replayed);
+        }
+        if (rewrite) {
+            saveUsers();
+        }
+    }
+
+    // Writes every user to a fresh users file and empties the users journal
+    void saveUsers() {
+        OperationTimer timer(Operation::SAVE_USERS);
+        auto lock = acquire<std::unique_lock<std::mutex>>(userMutex, LockSite::USERS);
+        // Settles every queued addition, so each uncommitted user is known to
+        // have either reached the journal or failed; failed ones are left out
+        // for their addUser call to remove
+        userJournal.flush();
+        bool written = replaceFile(usersFilePath, [this](const std::string& tempPath) {
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file.is_open()) {
+                std::cerr << "Failed to open users file for writing" << std::endl;
+                return false;
+            }
+            users.forEach([this, &file](const User& user) {
+                auto pending = uncommittedUsers.find(user.getUsername());
+                if (pending == uncommittedUsers.end() || !userJournal.hasFailed(pending->second)) {
+                    file << user.serialize() << '\n';
+                }
+            });
+            file.close();
+            if (!file) {
+                std::cerr << "Failed to write users file" << std::endl;
+                return false;
+            }
+            return true;
+        });
+        if (written) {
+            userJournal.reset();
         }
-        file.close();
     }
 };
 
@@ -0,0 +1,142 @@
+// taskpatch.h
+#ifndef TASKPATCH_H
+#define TASKPATCH_H
+
+#include "task.h"
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <stdexcept>
+#include <cstdint>
+
+// Bits of TaskPatch::getFields()
+enum class TaskField : uint8_t {
+    COMPLETED = 1,
+    PRIORITY = 2,
+    SHARED = 4,
+    ASSIGNEE = 8,
+    CATEGORY = 16,
+    TITLE = 32
+};
+
+// Set of field changes for TaskManager::patchTask; fields that were not set
+// keep their current value. Setters chain:
+//   taskManager.patchTask(id, TaskPatch().setCompleted(true), sessionId);
+class TaskPatch {
+private:
+    uint8_t fields;
+    bool completed;
+    Priority priority;
+    bool isShared;
+    std::string assignedTo;
+    std::string category;
+    std::string title;
+
+    void mark(TaskField field) { fields |= static_cast<uint8_t>(field); }
+
+    static int parseNumber(std::string_view field) {
+        int value;
+        auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+        if (result.ec != std::errc() || result.ptr != field.data() + field.size()) {
+            throw std::runtime_error("Invalid number in task patch");
+        }
+        return value;
+    }
+
+    // Removes and returns the text up to the next '|', or all of it
+    static std::string_view nextField(std::string_view& data) {
+        size_t pos = data.find('|');
+        std::string_view field = data.substr(0, pos);
+        data.remove_prefix(pos == std::string_view::npos ? data.size() : pos + 1);
+        return field;
+    }
+
+public:
+    TaskPatch() : fields(0), completed(false), priority(Priority::LOW), isShared(false) {}
+
+    TaskPatch& setCompleted(bool value) { completed = value; mark(TaskField::COMPLETED); return *this; }
+    TaskPatch& setPriority(Priority value) { priority = value; mark(TaskField::PRIORITY); return *this; }
+    TaskPatch& setShared(bool value) { isShared = value; mark(TaskField::SHARED); return *this; }
+    TaskPatch& setAssignedTo(const std::string& value) { assignedTo = value; mark(TaskField::ASSIGNEE); return *this; }
+    TaskPatch& setCategory(const std::string& value) { category = value; mark(TaskField::CATEGORY); return *this; }
+    TaskPatch& setTitle(const std::string& value) { title = value; mark(TaskField::TITLE); return *this; }
+
+    bool has(TaskField field) const { return fields & static_cast<uint8_t>(field); }
+    bool empty() const { return fields == 0; }
+    uint8_t getFields() const { return fields; }
+
+    bool isCompleted() const { return completed; }
+    Priority getPriority() const { return priority; }
+    bool getIsShared() const { return isShared; }
+    const std::string& getAssignedTo() const { return assignedTo; }
+    const std::string& getCategory() const { return category; }
+    const std::string& getTitle() const { return title; }
+
+    // Journal form: <task id>|<field bits>, then the value of each set field
+    // in bit order. The title comes last so it may contain anything but a
+    // newline.
+    std::string serialize(int taskId) const {
+        std::string record = std::to_string(taskId);
+        record += '|';
+        record += std::to_string(fields);
+        if (has(TaskField::COMPLETED)) {
+            record += completed ? "|1" : "|0";
+        }
+        if (has(TaskField::PRIORITY)) {
+            record += '|';
+            record += std::to_string(static_cast<int>(priority));
+        }
+        if (has(TaskField::SHARED)) {
+            record += isShared ? "|1" : "|0";
+        }
+        if (has(TaskField::ASSIGNEE)) {
+            record += '|';
+            record += assignedTo;
+        }
+        if (has(TaskField::CATEGORY)) {
+            record += '|';
+            record += category;
+        }
+        if (has(TaskField::TITLE)) {
+            record += '|';
+            record += title;
+        }
+        return record;
+    }
+
+    static TaskPatch parse(std::string_view data, int& taskId) {
+        taskId = parseNumber(nextField(data));
+        int bits = parseNumber(nextField(data));
+        if (bits <= 0 || bits > 63) {
+            throw std::runtime_error("Invalid task patch fields");
+        }
+        TaskPatch patch;
+        patch.fields = static_cast<uint8_t>(bits);
+        if (patch.has(TaskField::COMPLETED)) {
+            patch.completed = nextField(data) == "1";
+        }
+        if (patch.has(TaskField::PRIORITY)) {
+            int value = parseNumber(nextField(data));
+            if (value < static_cast<int>(Priority::LOW) || value > static_cast<int>(Priority::HIGH)) {
+                throw std::runtime_error("Invalid task priority");
+            }
+            patch.priority = static_cast<Priority>(value);
+        }
+        if (patch.has(TaskField::SHARED)) {
+            patch.isShared = nextField(data) == "1";
+        }
+        if (patch.has(TaskField::ASSIGNEE)) {
+            patch.assignedTo = std::string(nextField(data));
+        }
+        if (patch.has(TaskField::CATEGORY)) {
+            patch.category = std::string(nextField(data));
+        }
+        if (patch.has(TaskField::TITLE)) {
+            patch.title = std::string(data);
+        }
+        return patch;
+    }
+};
+
+#endif // TASKPATCH_H
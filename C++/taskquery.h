@@ -0,0 +1,152 @@
+// taskquery.h
+#ifndef TASKQUERY_H
+#define TASKQUERY_H
+
+#include "storedtask.h"
+#include "taskshard.h"
+
+#include <string>
+#include <vector>
+#include <set>
+#include <optional>
+#include <ctime>
+#include <cstdint>
+
+enum class SortField { ID, CREATED_AT, PRIORITY, TITLE };
+
+// Conjunction of optional filters over task fields, plus ordering and an
+// optional limit. Unset filters match everything.
+struct TaskQuery {
+    std::optional<std::string> category;
+    std::optional<std::string> assignedTo;
+    std::optional<bool> completed;
+    std::optional<Priority> priority;
+    std::optional<bool> isShared;
+    std::optional<time_t> createdFrom; // Inclusive
+    std::optional<time_t> createdTo;   // Exclusive
+
+    SortField sortBy = SortField::ID;
+    bool descending = false;
+    size_t limit = SIZE_MAX;
+
+    // assignee and categoryId are assignedTo and category resolved to their
+    // interned ids
+    bool matches(const StoredTask& task, UserId assignee, CategoryId categoryId) const {
+        return (!assignedTo || task.getAssigneeId() == assignee) &&
+               (!completed || task.isCompleted() == *completed) &&
+               (!priority || task.getPriority() == *priority) &&
+               (!isShared || task.getIsShared() == *isShared) &&
+               (!createdFrom || task.getCreatedAt() >= *createdFrom) &&
+               (!createdTo || task.getCreatedAt() < *createdTo) &&
+               (!category || task.getCategoryId() == categoryId);
+    }
+
+    // Whether a comes before b in the requested order; ties are broken by id
+    bool sortsBefore(const StoredTask& a, const StoredTask& b) const {
+        return descending ? ascending(b, a) : ascending(a, b);
+    }
+
+private:
+    bool ascending(const StoredTask& a, const StoredTask& b) const {
+        switch (sortBy) {
+        case SortField::CREATED_AT:
+            if (a.getCreatedAt() != b.getCreatedAt()) {
+                return a.getCreatedAt() < b.getCreatedAt();
+            }
+            break;
+        case SortField::PRIORITY:
+            if (a.getPriority() != b.getPriority()) {
+                return a.getPriority() < b.getPriority();
+            }
+            break;
+        case SortField::TITLE: {
+            int order = a.getTitle().compare(b.getTitle());
+            if (order != 0) {
+                return order < 0;
+            }
+            break;
+        }
+        case SortField::ID:
+            break;
+        }
+        return a.getId() < b.getId();
+    }
+};
+
+// Calls visit(const StoredTask&) on every task in the shard that could match the
+// query, using whichever index yields the fewest candidates and falling
+// back to a scan of the whole shard: over its columns when the store keeps
+// them, otherwise over its dense task array. Candidates still have to be
+// checked with TaskQuery::matches.
+template <typename Visitor>
+void forEachCandidate(const TaskShard& shard, const TaskQuery& query, UserId assignee, Visitor visit) {
+    const std::set<int>* best = nullptr;
+    size_t bestSize = shard.tasks.size();
+    auto consider = [&best, &bestSize](const std::set<int>& ids) {
+        if (ids.size() < bestSize) {
+            best = &ids;
+            bestSize = ids.size();
+        }
+    };
+    if (query.assignedTo) {
+        consider(shard.index.assignedTo(assignee));
+    }
+    if (query.category) {
+        consider(shard.index.inCategory(*query.category));
+    }
+    if (query.isShared && *query.isShared) {
+        consider(shard.index.sharedTasks());
+    }
+
+    // The completion bitsets win only when they beat every id set
+    size_t bitsetSize = SIZE_MAX;
+    if (query.completed) {
+        bitsetSize = *query.completed ? shard.index.completedCount() : shard.index.pendingCount();
+    }
+
+    if (bitsetSize < bestSize) {
+        auto visitId = [&shard, &visit](int taskId) {
+            visit(*shard.tasks.find(taskId));
+        };
+        if (*query.completed) {
+            shard.index.forEachCompleted(visitId);
+        } else {
+            shard.index.forEachPending(visitId);
+        }
+    } else if (best) {
+        for (int taskId : *best) {
+            visit(*shard.tasks.find(taskId));
+        }
+    } else if (const TaskColumns* columns = shard.tasks.getColumns()) {
+        std::vector<uint64_t> mask = columns->allRows();
+        if (query.completed) {
+            columns->whereCompleted(*query.completed, mask);
+        }
+        if (query.isShared) {
+            columns->whereShared(*query.isShared, mask);
+        }
+        if (query.priority) {
+            columns->wherePriority(*query.priority, mask);
+        }
+        if (query.assignedTo) {
+            columns->whereAssignee(assignee, mask);
+        }
+        if (query.createdFrom || query.createdTo) {
+            columns->whereCreated(query.createdFrom ? *query.createdFrom : INT64_MIN,
+                                  query.createdTo ? *query.createdTo : INT64_MAX, mask);
+        }
+        for (size_t w = 0; w < mask.size(); ++w) {
+            uint64_t bits = mask[w];
+            while (bits) {
+                visit(shard.tasks.at(w * 64 + __builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
+        }
+    } else {
+        for (const auto& task : shard.tasks) {
+            visit(task);
+        }
+    }
+}
+
+#endif // TASKQUERY_H
@@ -0,0 +1,29 @@
+// taskshard.h
+#ifndef TASKSHARD_H
+#define TASKSHARD_H
+
+#include "taskstore.h"
+#include "taskindex.h"
+
+#include <shared_mutex>
+
+// Tasks are spread over shards by id so that writers to different shards do
+// not contend. Readers take the shard lock shared, writers exclusive.
+const int TASK_SHARD_COUNT = 16;
+
+struct TaskShard {
+    std::shared_mutex mutex;
+    TaskStore tasks;
+    TaskIndex index;
+
+    // Ids in one shard are TASK_SHARD_COUNT apart, so the store's slot table
+    // and the index's bitsets are keyed by id / TASK_SHARD_COUNT to stay dense.
+    TaskShard() : tasks(TASK_SHARD_COUNT), index(TASK_SHARD_COUNT) {}
+};
+
+// Sequential ids map round-robin onto shards
+inline int shardOf(int taskId) {
+    return static_cast<int>(static_cast<unsigned>(taskId) % TASK_SHARD_COUNT);
+}
+
+#endif // TASKSHARD_H
@@ -0,0 +1,217 @@
+// taskstore.h
+#ifndef TASKSTORE_H
+#define TASKSTORE_H
+
+#include "task.h"
+#include "storedtask.h"
+#include "stringarena.h"
+#include "taskcolumns.h"
+
+#include <vector>
+#include <stdexcept>
+#include <utility>
+#include <memory>
+#include <string_view>
+
+// Slot map of tasks keyed by id. Tasks live contiguously in a dense array so
+// listings scan linearly, while an id-indexed slot table gives O(1) lookup.
+// Deletion moves the last task into the freed position (swap-remove), so
+// positions are not stable; task ids are never reused and serve as the
+// stable handle instead.
+//
+// A store holding only every stride-th id (one shard of many) indexes its
+// slot table by id / stride.
+//
+// Tasks are kept as StoredTask records whose titles live in the store's
+// StringArena. Replaced titles stay in the arena as garbage until
+// compactStrings() copies the live ones into a fresh arena.
+//
+// Optionally the store also keeps TaskColumns, a columnar copy of the fixed-
+// width fields whose rows follow the dense positions. Tasks changed in place
+// through find() must then be passed to refresh().
+
+// Task records copied out of one or more stores, readable with no lock held
+// while the stores move on. Title bytes are never overwritten in place, and
+// the snapshot shares ownership of the arenas they live in, so an arena the
+// store has since compacted away or cleared survives until the snapshot is
+// dropped.
+struct TaskStoreSnapshot {
+    std::vector<StoredTask> tasks;
+    std::vector<std::shared_ptr<const StringArena>> arenas;
+
+    size_t size() const { return tasks.size(); }
+    std::vector<StoredTask>::const_iterator begin() const { return tasks.begin(); }
+    std::vector<StoredTask>::const_iterator end() const { return tasks.end(); }
+};
+
+class TaskStore {
+private:
+    std::vector<StoredTask> dense;
+    std::vector<int> slots; // task id / stride -> position in dense, or -1
+    int stride;
+    std::shared_ptr<StringArena> titles;
+    std::unique_ptr<TaskColumns> columns;
+
+    void storeTitle(StoredTask& task, std::string_view title) {
+        std::string_view stored = titles->store(title);
+        task.title = stored.data();
+        task.titleLength = static_cast<uint32_t>(stored.size());
+    }
+
+public:
+    explicit TaskStore(int stride = 1) : stride(stride), titles(std::make_shared<StringArena>()) {}
+
+    typedef std::vector<StoredTask>::iterator iterator;
+    typedef std::vector<StoredTask>::const_iterator const_iterator;
+
+    size_t size() const { return dense.size(); }
+    bool empty() const { return dense.empty(); }
+
+    iterator begin() { return dense.begin(); }
+    iterator end() { return dense.end(); }
+    const_iterator begin() const { return dense.begin(); }
+    const_iterator end() const { return dense.end(); }
+
+    const std::vector<StoredTask>& all() const { return dense; }
+    const StoredTask& at(size_t position) const { return dense[position]; }
+
+    void enableColumns(bool enabled) {
+        if (!enabled) {
+            columns.reset();
+        } else if (!columns) {
+            columns.reset(new TaskColumns());
+            columns->reserve(dense.size());
+            for (const auto& task : dense) {
+                columns->push(task);
+            }
+        }
+    }
+
+    // Null unless columns are enabled
+    const TaskColumns* getColumns() const { return columns.get(); }
+
+    void refresh(int taskId) {
+        if (columns && find(taskId)) {
+            columns->set(static_cast<size_t>(slots[taskId / stride]), dense[slots[taskId / stride]]);
+        }
+    }
+
+    StoredTask* find(int taskId) {
+        if (taskId < 0) {
+            return nullptr;
+        }
+        size_t slot = static_cast<size_t>(taskId / stride);
+        if (slot >= slots.size() || slots[slot] < 0) {
+            return nullptr;
+        }
+        return &dense[slots[slot]];
+    }
+
+    const StoredTask* find(int taskId) const {
+        return const_cast<TaskStore*>(this)->find(taskId);
+    }
+
+    // Inserts a copy of task, replacing any stored task with the same id
+    StoredTask& upsert(const Task& task) {
+        int taskId = task.getId();
+        if (taskId < 0) {
+            throw std::invalid_argument("Invalid task id");
+        }
+        StoredTask stored;
+        stored.id = taskId;
+        stored.assignedTo = task.getAssigneeId();
+        stored.category = CategoryNames::instance().intern(task.getCategory());
+        stored.createdAt = task.getCreatedAt();
+        stored.completed = task.isCompleted();
+        stored.priority = task.getPriority();
+        stored.isShared = task.getIsShared();
+        storeTitle(stored, task.getTitle());
+
+        size_t slot = static_cast<size_t>(taskId / stride);
+        if (slot >= slots.size()) {
+            slots.resize(slot + 1, -1);
+        }
+        if (slots[slot] >= 0) {
+            StoredTask& existing = dense[slots[slot]];
+            titles->release(existing.getTitle());
+            existing = stored;
+            if (columns) {
+                columns->set(static_cast<size_t>(slots[slot]), existing);
+            }
+            return existing;
+        }
+        slots[slot] = static_cast<int>(dense.size());
+        dense.push_back(stored);
+        if (columns) {
+            columns->push(dense.back());
+        }
+        return dense.back();
+    }
+
+    void setTitle(StoredTask& task, std::string_view title) {
+        if (task.getTitle() != title) {
+            titles->release(task.getTitle());
+            storeTitle(task, title);
+        }
+    }
+
+    // Bytes held by replaced or deleted titles
+    size_t stringGarbage() const { return titles->garbage(); }
+
+    // Moves the live titles into a fresh arena once at least half of the
+    // current one is garbage; the old arena is freed when no snapshot holds it
+    void compactStrings() {
+        if (titles->garbage() == 0 || titles->garbage() < titles->live()) {
+            return;
+        }
+        auto fresh = std::make_shared<StringArena>();
+        for (auto& task : dense) {
+            std::string_view stored = fresh->store(task.getTitle());
+            task.title = stored.data();
+        }
+        titles = std::move(fresh);
+    }
+
+    // Appends a copy of every task record to snapshot. Costs one copy of the
+    // fixed-size records; no title is copied.
+    void snapshotInto(TaskStoreSnapshot& snapshot) const {
+        snapshot.tasks.insert(snapshot.tasks.end(), dense.begin(), dense.end());
+        snapshot.arenas.push_back(titles);
+    }
+
+    bool erase(int taskId) {
+        if (!find(taskId)) {
+            return false;
+        }
+        int position = slots[taskId / stride];
+        titles->release(dense[position].getTitle());
+        if (static_cast<size_t>(position) != dense.size() - 1) {
+            dense[position] = dense.back();
+            slots[dense[position].getId() / stride] = position;
+        }
+        dense.pop_back();
+        slots[taskId / stride] = -1;
+        if (columns) {
+            columns->remove(static_cast<size_t>(position));
+        }
+        return true;
+    }
+
+    void clear() {
+        dense.clear();
+        slots.clear();
+        titles = std::make_shared<StringArena>(); // Snapshots may still hold the old one
+        if (columns) {
+            columns->clear();
+        }
+    }
+
+    void reserve(size_t count) {
+        dense.reserve(count);
+        if (columns) {
+            columns->reserve(count);
+        }
+    }
+};
+
+#endif // TASKSTORE_H
@@ -0,0 +1,232 @@
+// textindex.h
+#ifndef TEXTINDEX_H
+#define TEXTINDEX_H
+
+#include "storedtask.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+
+// Parsed search text: every term must match. A term typed with a trailing
+// '*' matches any token it is a prefix of, the rest match whole tokens.
+struct TextQuery {
+    std::vector<std::string> terms;
+    std::vector<bool> isPrefix;
+
+    bool empty() const { return terms.empty(); }
+};
+
+// Inverted index from title and category tokens to the sorted ids of the
+// tasks containing them. Tokens are runs of ASCII letters and digits,
+// lowercased; bytes of multi-byte UTF-8 characters count as letters. The
+// token map is ordered so that a prefix covers one contiguous range.
+class TextIndex {
+private:
+    std::map<std::string, std::vector<int>, std::less<>> postings;
+
+    static bool isTokenByte(unsigned char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+    }
+
+    // Sorted, duplicate-free tokens of a task
+    static std::vector<std::string> tokensOf(const StoredTask& task) {
+        std::vector<std::string> tokens;
+        auto collect = [&tokens](std::string&& token, size_t) {
+            tokens.push_back(std::move(token));
+        };
+        tokenize(task.getTitle(), collect);
+        tokenize(task.getCategory(), collect);
+        std::sort(tokens.begin(), tokens.end());
+        tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+        return tokens;
+    }
+
+    static bool startsWith(std::string_view token, std::string_view prefix) {
+        return token.size() >= prefix.size() && token.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    static bool taskHasPrefix(const StoredTask& task, const std::string& prefix) {
+        bool found = false;
+        auto check = [&found, &prefix](std::string&& token, size_t) {
+            found = found || startsWith(token, prefix);
+        };
+        tokenize(task.getTitle(), check);
+        tokenize(task.getCategory(), check);
+        return found;
+    }
+
+    // Total postings under a prefix, used to pick the cheapest term
+    size_t prefixSize(const std::string& prefix) const {
+        size_t total = 0;
+        for (auto it = postings.lower_bound(prefix); it != postings.end() && startsWith(it->first, prefix); ++it) {
+            total += it->second.size();
+        }
+        return total;
+    }
+
+public:
+    // Calls visit(token, end) for each token, where end is the offset just
+    // past the token in text
+    template <typename Visitor>
+    static void tokenize(std::string_view text, Visitor visit) {
+        size_t i = 0;
+        while (i < text.size()) {
+            while (i < text.size() && !isTokenByte(static_cast<unsigned char>(text[i]))) {
+                ++i;
+            }
+            std::string token;
+            while (i < text.size() && isTokenByte(static_cast<unsigned char>(text[i]))) {
+                char c = text[i++];
+                token += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            }
+            if (!token.empty()) {
+                visit(std::move(token), i);
+            }
+        }
+    }
+
+    static TextQuery parseQuery(std::string_view text) {
+        TextQuery query;
+        tokenize(text, [&query, text](std::string&& token, size_t end) {
+            query.terms.push_back(std::move(token));
+            query.isPrefix.push_back(end < text.size() && text[end] == '*');
+        });
+        return query;
+    }
+
+    void add(const StoredTask& task) {
+        int taskId = task.getId();
+        for (const auto& token : tokensOf(task)) {
+            std::vector<int>& ids = postings[token];
+            // Ids mostly arrive in increasing order
+            if (ids.empty() || ids.back() < taskId) {
+                ids.push_back(taskId);
+            } else {
+                auto it = std::lower_bound(ids.begin(), ids.end(), taskId);
+                if (it == ids.end() || *it != taskId) {
+                    ids.insert(it, taskId);
+                }
+            }
+        }
+    }
+
+    void remove(const StoredTask& task) {
+        int taskId = task.getId();
+        for (const auto& token : tokensOf(task)) {
+            auto entry = postings.find(token);
+            if (entry == postings.end()) {
+                continue;
+            }
+            std::vector<int>& ids = entry->second;
+            auto it = std::lower_bound(ids.begin(), ids.end(), taskId);
+            if (it != ids.end() && *it == taskId) {
+                ids.erase(it);
+            }
+            if (ids.empty()) {
+                postings.erase(entry);
+            }
+        }
+    }
+
+    void clear() {
+        postings.clear();
+    }
+
+    size_t tokenCount() const { return postings.size(); }
+
+    // Calls visit(const StoredTask&) for every task matching all terms, in id
+    // order, until visit returns false. The term with the fewest postings
+    // drives the scan; exact terms are checked against their posting lists
+    // and prefix terms against the candidate's own tokens. lookup(id)
+    // returns the stored task.
+    template <typename Lookup, typename Visitor>
+    void search(const TextQuery& query, Lookup lookup, Visitor visit) const {
+        if (query.empty()) {
+            return;
+        }
+        size_t driver = 0;
+        size_t driverSize = SIZE_MAX;
+        std::vector<const std::vector<int>*> exact(query.terms.size(), nullptr);
+        for (size_t t = 0; t < query.terms.size(); ++t) {
+            size_t size;
+            if (query.isPrefix[t]) {
+                size = prefixSize(query.terms[t]);
+            } else {
+                auto it = postings.find(query.terms[t]);
+                if (it == postings.end()) {
+                    return; // A required token appears nowhere
+                }
+                exact[t] = &it->second;
+                size = it->second.size();
+            }
+            if (size < driverSize) {
+                driver = t;
+                driverSize = size;
+            }
+        }
+
+        auto consider = [&](int taskId) {
+            const StoredTask* task = nullptr;
+            bool matched = true;
+            for (size_t t = 0; t < query.terms.size() && matched; ++t) {
+                if (t == driver) {
+                    continue;
+                }
+                if (exact[t]) {
+                    matched = std::binary_search(exact[t]->begin(), exact[t]->end(), taskId);
+                } else {
+                    if (!task) {
+                        task = lookup(taskId);
+                    }
+                    matched = taskHasPrefix(*task, query.terms[t]);
+                }
+            }
+            return !matched || visit(task ? *task : *lookup(taskId));
+        };
+
+        if (exact[driver]) {
+            for (int taskId : *exact[driver]) {
+                if (!consider(taskId)) {
+                    return;
+                }
+            }
+            return;
+        }
+
+        // A prefix driver merges the posting lists of every token under it
+        // lazily, so an early stop leaves the rest untouched
+        typedef std::vector<int>::const_iterator Position;
+        typedef std::pair<Position, Position> Range;
+        auto later = [](const Range& a, const Range& b) { return *a.first > *b.first; };
+        std::vector<Range> heap;
+        const std::string& prefix = query.terms[driver];
+        for (auto it = postings.lower_bound(prefix); it != postings.end() && startsWith(it->first, prefix); ++it) {
+            heap.emplace_back(it->second.begin(), it->second.end());
+        }
+        std::make_heap(heap.begin(), heap.end(), later);
+        int previous = -1;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            Range& range = heap.back();
+            int taskId = *range.first++;
+            if (range.first == range.second) {
+                heap.pop_back();
+            } else {
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+            if (taskId != previous) {
+                previous = taskId;
+                if (!consider(taskId)) {
+                    return;
+                }
+            }
+        }
+    }
+};
+
+#endif // TEXTINDEX_H
@@ -0,0 +1,120 @@
+// textparser.h
+#ifndef TEXTPARSER_H
+#define TEXTPARSER_H
+
+#include "task.h"
+#include "user.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+// Streaming readers for the pipe-delimited tasks.txt / users.txt formats.
+// Files are read through one large buffer and split into string_view lines,
+// so no per-line std::string is allocated before a record is parsed.
+const size_t TEXT_READ_BUFFER_SIZE = size_t(1) << 20;
+
+// Calls visit(line, lineNumber) for every line of the file at path, without
+// its line terminator. The view is only valid during the call. Returns false
+// if the file cannot be opened.
+template <typename Visitor>
+bool forEachLine(const std::string& path, Visitor visit) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    std::vector<char> buffer(TEXT_READ_BUFFER_SIZE);
+    size_t filled = 0;
+    size_t lineNumber = 0;
+    while (true) {
+        size_t read = std::fread(buffer.data() + filled, 1, buffer.size() - filled, file);
+        filled += read;
+
+        size_t start = 0;
+        while (start < filled) {
+            const void* newline = std::memchr(buffer.data() + start, '\n', filled - start);
+            if (!newline) {
+                break;
+            }
+            size_t end = static_cast<const char*>(newline) - buffer.data();
+            std::string_view line(buffer.data() + start, end - start);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            visit(line, ++lineNumber);
+            start = end + 1;
+        }
+
+        if (read == 0) {
+            if (start < filled) {
+                visit(std::string_view(buffer.data() + start, filled - start), ++lineNumber);
+            }
+            break;
+        }
+
+        // Carry the partial last line over; grow if one line fills the buffer
+        std::memmove(buffer.data(), buffer.data() + start, filled - start);
+        filled -= start;
+        if (filled == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+    }
+    std::fclose(file);
+    return true;
+}
+
+// Like forEachLine, over text already in memory. Returns the number of lines.
+template <typename Visitor>
+size_t forEachLineIn(std::string_view text, Visitor visit) {
+    size_t lineNumber = 0;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view line = text.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        visit(line, ++lineNumber);
+        start = end + 1;
+    }
+    return lineNumber;
+}
+
+// Parses every record of a tasks file, handing each Task to onTask.
+// Malformed lines are reported to onError(lineNumber, message) and skipped.
+// Returns the number of tasks parsed.
+template <typename TaskHandler, typename ErrorHandler>
+size_t parseTaskFile(const std::string& path, TaskHandler onTask, ErrorHandler onError) {
+    size_t parsed = 0;
+    forEachLine(path, [&](std::string_view line, size_t lineNumber) {
+        try {
+            onTask(Task::parse(line));
+            ++parsed;
+        } catch (const std::exception& e) {
+            onError(lineNumber, e.what());
+        }
+    });
+    return parsed;
+}
+
+template <typename UserHandler, typename ErrorHandler>
+size_t parseUserFile(const std::string& path, UserHandler onUser, ErrorHandler onError) {
+    size_t parsed = 0;
+    forEachLine(path, [&](std::string_view line, size_t lineNumber) {
+        try {
+            onUser(User::parse(line));
+            ++parsed;
+        } catch (const std::exception& e) {
+            onError(lineNumber, e.what());
+        }
+    });
+    return parsed;
+}
+
+#endif // TEXTPARSER_H
@@ -0,0 +1,173 @@
+// timerwheel.h
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Hierarchical timer wheel over integer ticks. Level L has 64 slots of 64^L
+// ticks each, so four levels span 64^4 ticks; later deadlines are parked in
+// the top level and placed again as it turns. Timers live in a pooled,
+// intrusively linked node array, so arm and cancel are O(1) and advancing
+// costs O(ticks passed + timers fired). Not thread-safe.
+class TimerWheel {
+public:
+    // Index of the node in the low 32 bits, its reuse count in the high 32,
+    // so cancelling a timer that already fired does nothing
+    typedef uint64_t TimerId;
+    static const TimerId NO_TIMER = ~TimerId(0);
+
+private:
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 4;
+    static const int32_t NIL = -1;
+
+    struct Node {
+        uint64_t deadline;
+        uint64_t payload;
+        int32_t prev;
+        int32_t next;
+        int32_t slot; // Index into heads, or NIL when not armed
+        uint32_t generation;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int32_t> freeNodes;
+    int32_t heads[LEVELS * SLOTS];
+    uint64_t current;
+    size_t armed;
+
+    int slotFor(uint64_t deadline) const {
+        uint64_t diff = deadline ^ current;
+        int level = 0;
+        while (level < LEVELS - 1 && (diff >> (SLOT_BITS * (level + 1))) != 0) {
+            ++level;
+        }
+        return level * SLOTS + static_cast<int>((deadline >> (SLOT_BITS * level)) & (SLOTS - 1));
+    }
+
+    void link(int32_t index) {
+        Node& node = nodes[index];
+        node.slot = slotFor(node.deadline);
+        node.prev = NIL;
+        node.next = heads[node.slot];
+        if (node.next != NIL) {
+            nodes[node.next].prev = index;
+        }
+        heads[node.slot] = index;
+    }
+
+    void unlink(int32_t index) {
+        Node& node = nodes[index];
+        if (node.prev != NIL) {
+            nodes[node.prev].next = node.next;
+        } else {
+            heads[node.slot] = node.next;
+        }
+        if (node.next != NIL) {
+            nodes[node.next].prev = node.prev;
+        }
+        node.slot = NIL;
+    }
+
+    void release(int32_t index) {
+        ++nodes[index].generation;
+        freeNodes.push_back(index);
+        --armed;
+    }
+
+    // Detaches and returns the list in a slot
+    int32_t take(int slot) {
+        int32_t first = heads[slot];
+        heads[slot] = NIL;
+        return first;
+    }
+
+public:
+    explicit TimerWheel(uint64_t now = 0) : current(now), armed(0) {
+        for (auto& head : heads) {
+            head = NIL;
+        }
+    }
+
+    uint64_t now() const { return current; }
+    size_t size() const { return armed; }
+
+    // Deadlines not after now() fire on the next tick
+    TimerId arm(uint64_t deadline, uint64_t payload) {
+        int32_t index;
+        if (!freeNodes.empty()) {
+            index = freeNodes.back();
+            freeNodes.pop_back();
+        } else {
+            index = static_cast<int32_t>(nodes.size());
+            nodes.push_back(Node{0, 0, NIL, NIL, NIL, 0});
+        }
+        Node& node = nodes[index];
+        node.deadline = deadline > current ? deadline : current + 1;
+        node.payload = payload;
+        link(index);
+        ++armed;
+        return (TimerId(node.generation) << 32) | static_cast<uint32_t>(index);
+    }
+
+    bool cancel(TimerId id) {
+        if (id == NO_TIMER) {
+            return false;
+        }
+        int32_t index = static_cast<int32_t>(id & 0xffffffffu);
+        if (index < 0 || static_cast<size_t>(index) >= nodes.size()) {
+            return false;
+        }
+        Node& node = nodes[index];
+        if (node.slot == NIL || node.generation != static_cast<uint32_t>(id >> 32)) {
+            return false;
+        }
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    // Moves time forward to now, calling expired(payload) for each timer
+    // whose deadline has passed. expired may arm new timers.
+    template <typename Callback>
+    void advance(uint64_t now, Callback expired) {
+        while (current < now) {
+            if (armed == 0) {
+                current = now;
+                return;
+            }
+            ++current;
+            // Entering a new turn of a level spreads the matching slot of
+            // the level above over the levels below
+            for (int level = 1; level < LEVELS; ++level) {
+                uint64_t lower = current >> (SLOT_BITS * (level - 1));
+                if ((lower & (SLOTS - 1)) != 0) {
+                    break;
+                }
+                int slot = level * SLOTS + static_cast<int>((current >> (SLOT_BITS * level)) & (SLOTS - 1));
+                for (int32_t index = take(slot); index != NIL;) {
+                    int32_t next = nodes[index].next;
+                    link(index);
+                    index = next;
+                }
+            }
+            for (int32_t index = take(static_cast<int>(current & (SLOTS - 1))); index != NIL;) {
+                int32_t next = nodes[index].next;
+                if (nodes[index].deadline > current) {
+                    link(index); // Parked beyond the wheel's span
+                } else {
+                    nodes[index].slot = NIL;
+                    uint64_t payload = nodes[index].payload;
+                    release(index);
+                    expired(payload);
+                }
+                index = next;
+            }
+        }
+    }
+};
+
+#endif // TIMERWHEEL_H
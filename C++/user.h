@@ -2,39 +2,166 @@
 #ifndef USER_H
 #define USER_H
 
+#include "sha256.h"
+
 #include <string>
+#include <string_view>
+#include <stdexcept>
+#include <random>
+#include <cstdint>
+
+// PBKDF2 cost for newly set passwords, about 40 ms per hash on current hardware
+const uint32_t DEFAULT_PASSWORD_HASH_ITERATIONS = 50000;
 
+// Passwords are stored as salted PBKDF2-HMAC-SHA256 hashes:
+//   username|pbkdf2-sha256$<iterations>$<salt hex>$<hash hex>
+// Records from older files hold the plaintext password instead; they load as
+// legacy users and are rehashed by upgrade() when they next log in.
 class User {
 private:
+    static const size_t SALT_SIZE = 16;
+
     std::string username;
-    std::string password;
+    std::string salt;
+    Sha256::Digest hash{};
+    uint32_t iterations; // 0 for a legacy plaintext record
+    std::string legacyPassword;
+
+    User() : iterations(0) {}
+
+    static std::string toHex(const uint8_t* bytes, size_t size) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        hex.reserve(size * 2);
+        for (size_t i = 0; i < size; ++i) {
+            hex += digits[bytes[i] >> 4];
+            hex += digits[bytes[i] & 0xf];
+        }
+        return hex;
+    }
+
+    static int hexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        throw std::runtime_error("Invalid hex digit in password hash");
+    }
+
+    static std::string fromHex(std::string_view hex) {
+        if (hex.size() % 2 != 0) {
+            throw std::runtime_error("Invalid hex length in password hash");
+        }
+        std::string bytes;
+        bytes.reserve(hex.size() / 2);
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            bytes += static_cast<char>(hexDigit(hex[i]) * 16 + hexDigit(hex[i + 1]));
+        }
+        return bytes;
+    }
+
+    // Splits off the text up to the next '$'
+    static std::string_view nextField(std::string_view& data) {
+        size_t pos = data.find('$');
+        if (pos == std::string_view::npos) {
+            throw std::runtime_error("Invalid password hash format");
+        }
+        std::string_view field = data.substr(0, pos);
+        data.remove_prefix(pos + 1);
+        return field;
+    }
+
+    void setPassword(const std::string& password, uint32_t hashIterations) {
+        static thread_local std::random_device device;
+        salt.resize(SALT_SIZE);
+        for (size_t i = 0; i < SALT_SIZE; i += 4) {
+            uint32_t word = device();
+            for (size_t b = 0; b < 4; ++b) {
+                salt[i + b] = static_cast<char>(word >> (8 * b));
+            }
+        }
+        iterations = hashIterations > 0 ? hashIterations : 1;
+        hash = pbkdf2Sha256(password, salt, iterations);
+        legacyPassword.clear();
+    }
 
 public:
-    User(const std::string& username, const std::string& password)
-        : username(username), password(password) {}
+    static constexpr std::string_view HASH_SCHEME = "pbkdf2-sha256$";
+
+    // Hashes password with a fresh random salt
+    User(const std::string& username, const std::string& password,
+         uint32_t hashIterations = DEFAULT_PASSWORD_HASH_ITERATIONS)
+        : username(username), iterations(0) {
+        setPassword(password, hashIterations);
+    }
 
     std::string getUsername() const { return username; }
+    uint32_t getHashIterations() const { return iterations; }
+    bool isLegacy() const { return iterations == 0; }
+
+    // Costs one full PBKDF2 run, which is what makes guessing expensive
     bool authenticate(const std::string& inputPassword) const {
-        return password == inputPassword;
+        if (isLegacy()) {
+            return digestsEqual(Sha256::hash(legacyPassword), Sha256::hash(inputPassword));
+        }
+        return digestsEqual(pbkdf2Sha256(inputPassword, salt, iterations), hash);
+    }
+
+    // Replaces a legacy plaintext password with its hash
+    void upgrade(uint32_t hashIterations) {
+        if (isLegacy()) {
+            setPassword(legacyPassword, hashIterations);
+        }
     }
 
     // Serialize user to string for file storage
     std::string serialize() const {
-        return username + "|" + password;
+        if (isLegacy()) {
+            return username + "|" + legacyPassword;
+        }
+        return username + "|" + std::string(HASH_SCHEME) + std::to_string(iterations) + "$" +
+               toHex(reinterpret_cast<const uint8_t*>(salt.data()), salt.size()) + "$" +
+               toHex(hash.data(), hash.size());
     }
 
-    // Deserialize from string
-    static User deserialize(const std::string& data) {
-        size_t pos = data.find("|");
-        if (pos == std::string::npos) {
+    // Parses one record in place
+    static User parse(std::string_view data) {
+        if (!data.empty() && data.back() == '\r') {
+            data.remove_suffix(1);
+        }
+        size_t pos = data.find('|');
+        if (pos == std::string_view::npos) {
             throw std::runtime_error("Invalid user data format");
         }
-        
-        std::string username = data.substr(0, pos);
-        std::string password = data.substr(pos + 1);
-        
-        return User(username, password);
+
+        User user;
+        user.username = std::string(data.substr(0, pos));
+        std::string_view credential = data.substr(pos + 1);
+        if (credential.substr(0, HASH_SCHEME.size()) != HASH_SCHEME) {
+            user.legacyPassword = std::string(credential);
+            return user;
+        }
+
+        credential.remove_prefix(HASH_SCHEME.size());
+        std::string_view count = nextField(credential);
+        std::string_view saltHex = nextField(credential);
+        std::string hashBytes = fromHex(credential);
+        if (count.empty() || count.size() > 9 || count.find_first_not_of("0123456789") != std::string_view::npos ||
+            hashBytes.size() != Sha256::DIGEST_SIZE) {
+            throw std::runtime_error("Invalid password hash format");
+        }
+        user.iterations = static_cast<uint32_t>(std::stoul(std::string(count)));
+        if (user.iterations == 0) {
+            throw std::runtime_error("Invalid password hash iteration count");
+        }
+        user.salt = fromHex(saltHex);
+        std::copy(hashBytes.begin(), hashBytes.end(), user.hash.begin());
+        return user;
+    }
+
+    // Deserialize from string
+    static User deserialize(const std::string& data) {
+        return parse(data);
     }
 };
 
-#endif // USER_H
\ No newline at end of file
+#endif // USER_H
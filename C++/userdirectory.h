@@ -0,0 +1,218 @@
+// userdirectory.h
+#ifndef USERDIRECTORY_H
+#define USERDIRECTORY_H
+
+#include "user.h"
+#include "sha256.h"
+
+#include <unordered_map>
+#include <string>
+#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <cstdint>
+
+// Default lifetime of a verified login in the credential cache
+const std::chrono::seconds DEFAULT_CREDENTIAL_CACHE_TTL(60);
+
+// Users keyed by name. Password hashing, the expensive part of both
+// registration and login, runs outside the directory lock, so lookups only
+// contend with each other for a shared lock. Successful logins are
+// remembered for a short time as a keyed digest of the password, letting
+// clients that reconnect with the same credentials skip the hash; failed
+// attempts are never cached and always pay full cost. Legacy plaintext
+// records are hashed on their first successful login rather than at load.
+class UserDirectory {
+private:
+    struct CachedCredential {
+        Sha256::Digest proof;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // Inserts between sweeps of expired cache entries
+    static const size_t CACHE_SWEEP_INTERVAL = 1024;
+
+    std::unordered_map<std::string, User> users;
+    mutable std::shared_mutex mutex;
+    std::atomic<uint32_t> hashIterations;
+
+    HmacSha256 cacheKey; // Random per process, so cached proofs are useless elsewhere
+    std::unordered_map<std::string, CachedCredential> cache;
+    std::mutex cacheMutex;
+    std::atomic<uint32_t> cacheTtl; // Seconds; 0 disables the cache
+    size_t cacheInserts;
+
+    static std::string randomKey() {
+        std::random_device device;
+        std::string key;
+        for (int i = 0; i < 8; ++i) {
+            uint32_t word = device();
+            key.append(reinterpret_cast<const char*>(&word), sizeof(word));
+        }
+        return key;
+    }
+
+    Sha256::Digest credentialProof(const std::string& username, const std::string& password) const {
+        std::string message = username;
+        message += '\0';
+        message += password;
+        return cacheKey.sign(message);
+    }
+
+    bool cachedLogin(const std::string& username, const Sha256::Digest& proof) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(username);
+        if (it == cache.end()) {
+            return false;
+        }
+        if (it->second.expires <= std::chrono::steady_clock::now()) {
+            cache.erase(it);
+            return false;
+        }
+        return digestsEqual(it->second.proof, proof);
+    }
+
+    void rememberLogin(const std::string& username, const Sha256::Digest& proof, uint32_t ttl) {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (++cacheInserts % CACHE_SWEEP_INTERVAL == 0) {
+            for (auto it = cache.begin(); it != cache.end();) {
+                it = it->second.expires <= now ? cache.erase(it) : std::next(it);
+            }
+        }
+        cache[username] = CachedCredential{proof, now + std::chrono::seconds(ttl)};
+    }
+
+public:
+    UserDirectory()
+        : hashIterations(DEFAULT_PASSWORD_HASH_ITERATIONS), cacheKey(randomKey()),
+          cacheTtl(static_cast<uint32_t>(DEFAULT_CREDENTIAL_CACHE_TTL.count())), cacheInserts(0) {}
+
+    // Cost of passwords hashed from now on; stored users keep theirs
+    void setHashIterations(uint32_t iterations) {
+        hashIterations = iterations > 0 ? iterations : 1;
+    }
+
+    void setCacheTtl(std::chrono::seconds ttl) {
+        cacheTtl = static_cast<uint32_t>(ttl.count());
+        if (ttl.count() == 0) {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            cache.clear();
+        }
+    }
+
+    bool contains(const std::string& username) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return users.count(username) != 0;
+    }
+
+    // Hashes password at the current cost without taking any lock
+    User create(const std::string& username, const std::string& password) const {
+        return User(username, password, hashIterations);
+    }
+
+    // Returns false if the name is taken
+    bool add(const std::string& username, const std::string& password) {
+        if (contains(username)) {
+            return false;
+        }
+        return insert(create(username, password));
+    }
+
+    // Keeps the first record for a name; used when loading
+    bool insert(User&& user) {
+        std::string username = user.getUsername();
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return users.try_emplace(username, std::move(user)).second;
+    }
+
+    // Overwrites any record for the name; used when replaying upgrades
+    void replace(User&& user) {
+        std::string username = user.getUsername();
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        users.insert_or_assign(username, std::move(user));
+    }
+
+    bool remove(const std::string& username) {
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            if (users.erase(username) == 0) {
+                return false;
+            }
+        }
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache.erase(username);
+        return true;
+    }
+
+    // If this login upgraded a legacy record, its new serialized form is
+    // stored in upgradedRecord for the caller to persist
+    bool authenticate(const std::string& username, const std::string& password,
+                      std::string* upgradedRecord = nullptr) {
+        uint32_t ttl = cacheTtl.load(std::memory_order_relaxed);
+        Sha256::Digest proof{};
+        if (ttl > 0) {
+            proof = credentialProof(username, password);
+            if (cachedLogin(username, proof)) {
+                return true;
+            }
+        }
+
+        std::optional<User> user;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = users.find(username);
+            if (it == users.end()) {
+                return false;
+            }
+            user = it->second;
+        }
+        if (!user->authenticate(password)) {
+            return false;
+        }
+        if (user->isLegacy()) {
+            user->upgrade(hashIterations);
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            auto it = users.find(username);
+            // A concurrent login may have upgraded it already
+            if (it != users.end() && it->second.isLegacy()) {
+                if (upgradedRecord) {
+                    *upgradedRecord = user->serialize();
+                }
+                it->second = std::move(*user);
+            }
+        }
+        if (ttl > 0) {
+            rememberLogin(username, proof, ttl);
+        }
+        return true;
+    }
+
+    void clear() {
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            users.clear();
+        }
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache.clear();
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return users.size();
+    }
+
+    // Calls visit(const User&) for every user under the shared lock
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (const auto& entry : users) {
+            visit(entry.second);
+        }
+    }
+};
+
+#endif // USERDIRECTORY_H
@@ -0,0 +1,15 @@
+// usernames.h
+#ifndef USERNAMES_H
+#define USERNAMES_H
+
+#include "interntable.h"
+
+#include <cstdint>
+
+typedef uint32_t UserId;
+const UserId NO_USER = NOT_INTERNED;
+
+struct UserNamesTag {};
+typedef InternTable<UserNamesTag> UserNames;
+
+#endif // USERNAMES_H